@@ -1,4 +1,6 @@
 #include "world.hpp"
+#include "collision.hpp"
+#include "profiler.hpp"
 
 #include "gfxengine/material.hpp"
 #include "gfxengine/input_controller.hpp"
@@ -10,6 +12,7 @@
 #include "gfxengine/noise_generator.hpp"
 #include "gfxengine/logger.hpp"
 
+#include <cfloat>
 #include <random>
 
 #if GFXENGINE_EDITOR
@@ -36,17 +39,30 @@ private:
 	float render_scale = 1.0f;
 
 	float camera_fov = 90.0f;
+	float pick_distance = 8.0f; // blocks, for breaking and placing
+	bool place_lamps = false;   // right click places lamps instead of dirt
 
 	InputController input_controller;
+	double update_time = 0.0;
+
+	// Walk mode keeps the horizontal movement of input_controller and moves
+	// the player box under gravity against the world, Space jumps.
+	bool walk_mode = false;
+	bool walk_jump = false; // Space pressed since the last update
+	bool walk_on_ground = false;
+	float walk_velocity_y = 0.0f;
 
 	int world_radius = 2;
+	bool world_streaming = false;
+	int view_radius = 8;
 	int random_seed = 1337;
 	int random_count = 400;
 	std::mt19937 rng{ (uint32_t)random_seed };
 	std::unique_ptr<NoiseGenerator> world_gen = std::make_unique<NoiseGenerator>(random_seed);
 
-	World world;
+	// Declared before world, chunk mesh workers may still read it until world is destroyed.
 	MaterialManager materials;
+	World world;
 
 #if GFXENGINE_EDITOR
 	bool editor_demo_window = false;
@@ -54,19 +70,70 @@ private:
 	bool editors = true;
 	bool editor_coord = true;
 	bool editor_stats = true;
+	bool editor_profiler = false;
+	bool editor_profiler_capture = false; // keeps every event for dumping
+	ProfileHistory profile_history;
+	std::vector<ProfileEvent> profile_events; // collected this frame
+	std::vector<ProfileEvent> profile_session;
 
 	bool editor_gfx_wireframe = false;
 	bool editor_gfx_culling = true;
 	bool editor_gfx_depth = true;
+	bool editor_frustum_culling = true;
 
 	bool editor_window_vsync = false;
 	int editor_windows_limit = fps_limit;
 #endif // GFXENGINE_EDITOR
 
+	void update_walk(vec3 previous, float dt)
+	{
+		const float width = 0.6f;
+		const float height = 1.8f;
+		const float eye_height = 1.62f;
+		const float gravity = 28.0f;
+		const float jump_speed = 9.0f;
+
+		vec3 feet = previous - vec3{ 0.0f, eye_height, 0.0f };
+		Aabb box{ feet - vec3{ width / 2, 0.0f, width / 2 }, feet + vec3{ width / 2, height, width / 2 } };
+
+		// Climb out when walk mode starts inside terrain.
+		for (int i = 0; i < 256 && Collision::overlaps(world, box); ++i)
+		{
+			box.min.y += 1.0f;
+			box.max.y += 1.0f;
+			previous.y += 1.0f;
+		}
+
+		if (walk_jump && walk_on_ground)
+			walk_velocity_y = jump_speed;
+
+		walk_jump = false;
+		dt = std::min(dt, 0.1f); // a stall should not turn into one long fall
+		walk_velocity_y -= gravity * dt;
+
+		vec3 moved = input_controller.position - previous;
+		CollisionMove result = Collision::move(world, box, { moved.x, walk_velocity_y * dt, moved.z });
+
+		walk_on_ground = result.blocked & (1 << (int)Direction::Down);
+		if (result.blocked & (1 << (int)Direction::Down | 1 << (int)Direction::Up))
+			walk_velocity_y = 0.0f;
+
+		input_controller.position = previous + result.delta;
+	}
+
 	void on_update()
 	{
 		const double time = platform.get_time();
+		vec3 previous = input_controller.position;
 		input_controller.update_all(time);
+
+		if (walk_mode)
+			update_walk(previous, float(time - update_time));
+
+		update_time = time;
+
+		if (world_streaming)
+			world.stream(*world_gen, input_controller.position, view_radius, view_radius + 2);
 	}
 
 	void on_render(Frame &frame)
@@ -83,8 +150,10 @@ private:
 			const mat4 view = math::look_at(camera_pos, camera_pos + camera_front, vec3::unit_y());
 			const mat4 model = mat4::identity();
 			const mat4 mvp = proj * view * model;
-			materials.find(ItemID::Dirt)->uniforms[0] = mvp;
-			materials.find(ItemID::Dirt)->uniforms[3] = camera_pos;
+			const Frustum frustum = Frustum::from_matrix(mvp);
+			materials.block_material->uniforms[0] = mvp;
+			materials.block_material->uniforms[3] = camera_pos;
+			materials.block_material->uniforms[5] = vec3(math::floor(camera_pos / (float)Chunk::EDGE_SIZE));
 
 			frame.clear_background(ColorF(0.2f, 0.3f, 0.2f, 1.0f));
 
@@ -92,11 +161,25 @@ private:
 				.frame = frame,
 				.materials = materials,
 				.graphics = window->get_graphics(),
-				.model_offset = ivec3{},
+				.chunk_pos = ivec3{},
+				.frustum = editor_frustum_culling ? &frustum : nullptr,
+				.camera_pos = camera_pos,
 			};
 			world.on_render(params);
 		}
 
+#if GFXENGINE_EDITOR
+		if (editor_profiler)
+		{
+			profile_events.clear();
+			Profiler::collect(profile_events);
+			profile_history.add_frame(profile_events);
+
+			if (editor_profiler_capture)
+				profile_session.insert(profile_session.end(), profile_events.begin(), profile_events.end());
+		}
+#endif // GFXENGINE_EDITOR
+
 #if GFXENGINE_EDITOR
 		frame.on_draw_editor([this, &frame]() {
 
@@ -165,6 +248,62 @@ private:
 				ImGui::Text("cache indices:   %7d", (int)stats.cache_indices);
 				ImGui::Text("cache triangles: %7d", (int)stats.cache_indices / 3);
 
+				ImGui::Text("visible chunks:  %7d", (int)world.render_stats.visible_chunks);
+				ImGui::Text("culled chunks:   %7d", (int)world.render_stats.culled_chunks);
+				ImGui::Text("occluded chunks: %7d", (int)world.render_stats.occluded_chunks);
+				ImGui::Text("lod triangles:   %7d / %d full", (int)world.render_stats.triangles, (int)world.render_stats.full_triangles);
+
+				ImGui::Text("mesh queue:      %7d / %d in flight", (int)world.mesh_stats.queued, (int)world.mesh_stats.in_flight);
+				ImGui::Text("mesh uploads:    %7d / %d pending", (int)world.mesh_stats.uploaded, (int)world.mesh_stats.pending_uploads);
+				ImGui::Text("mesh skipped:    %7d", (int)world.mesh_stats.skipped);
+				ImGui::Text("mesh budget ms:  %7.2f / %.2f", world.mesh_stats.used_ms, world.mesh_budget_ms);
+				ImGui::Text("light steps:     %7d / %d pending", (int)world.light.stats.steps, (int)world.light.stats.pending);
+				ImGui::Text("relit chunks:    %7d", (int)world.light.stats.relit_chunks);
+
+				auto memory = world.memory_stats();
+
+				ImGui::Text("chunks:          %7d / %d overflow", (int)memory.chunks, (int)memory.overflow_chunks);
+				ImGui::Text("palette entries: %7d", (int)memory.palette_entries);
+				ImGui::Text("block KB:        %7d / %d dense", (int)(memory.block_bytes / 1024), (int)(memory.dense_block_bytes / 1024));
+				ImGui::Text("chunk KB:        %7d", (int)(memory.chunk_bytes / 1024));
+				ImGui::Text("cold chunks:     %7d / %d KB", (int)memory.cold_chunks, (int)(memory.cold_block_bytes / 1024));
+				ImGui::Text("empty chunks:    %7d", (int)memory.empty_chunks);
+				ImGui::Text("uniform solid:   %7d", (int)memory.uniform_solid_chunks);
+				ImGui::Text("light KB:        %7d", (int)(memory.light_bytes / 1024));
+
+				if (world_streaming)
+				{
+					ImGui::Text("chunk loads:     %7d", (int)world.stream_stats.loads);
+					ImGui::Text("chunk unloads:   %7d", (int)world.stream_stats.unloads);
+					ImGui::Text("pending loads:   %7d", (int)world.stream_stats.pending);
+				}
+
+				ImGui::Text("region loads:    %7d", (int)world.stream_stats.region_loads);
+
+				ImGui::SetWindowPos(_pos, ImGuiCond_Always);
+				_pos.y += ImGui::GetWindowSize().y + 5;
+				ImGui::End();
+			}
+
+			if (editor_profiler)
+			{
+				ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_AlwaysAutoResize);
+
+				// The history is a ring, start plotting after the latest frame.
+				int offset = int((profile_history.frame + 1) % ProfileHistory::FRAMES);
+
+				for (size_t s = 0; s < PROFILE_STAGE_MAX; ++s)
+				{
+					float const *history = profile_history.stage_ms[s];
+					char overlay[32];
+					snprintf(overlay, sizeof(overlay), "%6.3f ms", history[profile_history.frame]);
+
+					ImGui::PlotLines(Profiler::stage_name((ProfileStage)s), history, (int)ProfileHistory::FRAMES, offset, overlay, 0.0f, FLT_MAX, ImVec2(240, 40));
+				}
+
+				if (editor_profiler_capture)
+					ImGui::Text("captured events: %7d", (int)profile_session.size());
+
 				ImGui::SetWindowPos(_pos, ImGuiCond_Always);
 				_pos.y += ImGui::GetWindowSize().y + 5;
 				ImGui::End();
@@ -177,7 +316,11 @@ private:
 				ImGui::Checkbox("FPS", &editors);
 				ImGui::Checkbox("Coords", &editor_coord);
 				ImGui::Checkbox("Stats", &editor_stats);
+				if (ImGui::Checkbox("Profiler", &editor_profiler))
+					Profiler::enabled = editor_profiler;
 				ImGui::Checkbox("Speed Up", &speed_up);
+				ImGui::Checkbox("Walk", &walk_mode);
+				ImGui::Checkbox("Place Lamps", &place_lamps);
 				ImGui::Checkbox("ImGui Demo", &editor_demo_window);
 
 				ImGui::PushItemWidth(126);
@@ -186,6 +329,10 @@ private:
 				ImGui::PushItemWidth(80);
 				ImGui::InputInt("Random Seed", &random_seed, 0);
 				ImGui::InputInt("World Radius", &world_radius, 0);
+				ImGui::Checkbox("Stream World", &world_streaming);
+				ImGui::InputInt("View Radius", &view_radius, 0);
+				ImGui::InputInt("LOD Distance", &world.lod_distance, 0);
+				ImGui::InputFloat("Mesh Budget ms", &world.mesh_budget_ms, 0.5f);
 				ImGui::InputInt("Blocks per Chunk", &random_count, 0);
 				ImGui::PopItemWidth();
 
@@ -200,11 +347,16 @@ private:
 					world.init(*world_gen, {-world_radius,-world_radius,-world_radius}, {world_radius,world_radius,world_radius});
 				}
 
+				if (ImGui::Button("Save World"))
+					world.save_regions();
+
 				if (ImGui::CollapsingHeader("Graphics"))
 				{
 					ImGui::Checkbox("Wireframe", &editor_gfx_wireframe);
 					ImGui::Checkbox("Culling", &editor_gfx_culling);
 					ImGui::Checkbox("Depth Test", &editor_gfx_depth);
+					ImGui::Checkbox("Frustum Culling", &editor_frustum_culling);
+					ImGui::Checkbox("Cave Culling", &world.cave_culling);
 
 					ImGui::PushItemWidth(80);
 					ImGui::InputFloat("Render Scale", &render_scale);
@@ -213,6 +365,24 @@ private:
 					ImGui::PopItemWidth();
 				}
 
+				if (editor_profiler && ImGui::CollapsingHeader("Profiler"))
+				{
+					ImGui::Checkbox("Capture Session", &editor_profiler_capture);
+
+					if (ImGui::Button("Dump CSV"))
+						Profiler::write_csv("profile.csv", profile_session);
+
+					ImGui::SameLine();
+
+					if (ImGui::Button("Dump Trace"))
+						Profiler::write_chrome_trace("profile_trace.json", profile_session);
+
+					ImGui::SameLine();
+
+					if (ImGui::Button("Clear"))
+						profile_session.clear();
+				}
+
 				if (ImGui::CollapsingHeader("Window"))
 				{
 					if (ImGui::Checkbox("vsync", &editor_window_vsync))
@@ -279,6 +449,9 @@ private:
 				InputController::Direction direction;
 			};
 
+			if (event.type == KeyboardEvent::Type::Press && event.key == KeyboardEvent::Key::Space)
+				walk_jump = true;
+
 			KeyDir key_dirs[] {
 				{ KeyboardEvent::Key::W, InputController::Direction::Front },
 				{ KeyboardEvent::Key::S, InputController::Direction::Back },
@@ -323,6 +496,20 @@ private:
 			camera_fov = 90.0f;
 			input_controller.change_rotation_sensitivity(time, 0.1f * camera_fov / 90.0f);
 		}
+
+		// Left button breaks the block under the crosshair, right places one on the face looked at.
+		if (mouse_locked && event.locked && event.type == MouseEvent::Type::Press && (event.key == MouseEvent::Key::LMB || event.key == MouseEvent::Key::RMB))
+		{
+			RaycastHit hit = world.raycast(input_controller.position, input_controller.calc_front_direction(), pick_distance);
+
+			if (hit.hit)
+			{
+				if (event.key == MouseEvent::Key::LMB)
+					world.set_block(hit.block, ItemID::Air);
+				else if (hit.distance > 0.0f)
+					world.set_block(hit.block + direction_offset(hit.face), place_lamps ? ItemID::Lamp : ItemID::Dirt);
+			}
+		}
 	}
 
 	virtual void on_mouse_external_unlock(double time, MouseExternalUnlockEvent event) override
@@ -364,38 +551,67 @@ public:
 		{
 			auto params = CreateMaterialParams{};
 
-			params.attributes.add(ShaderFieldInfo{ "pos", ShaderFieldType::F32, false, 3 });
-			params.attributes.add(ShaderFieldInfo{ "normal", ShaderFieldType::F32, false, 3 });
-			params.attributes.add(ShaderFieldInfo{ "tex_coord", ShaderFieldType::F32, false, 2 });
-			params.attributes.add(ShaderFieldInfo{ "tex_offset", ShaderFieldType::F32, false, 2 });
+			// See BlockVertex for the bit layout.
+			params.attributes.add(ShaderFieldInfo{ "data", ShaderFieldType::U32, false, 1 });
+			params.attributes.add(ShaderFieldInfo{ "chunk", ShaderFieldType::U32, false, 1 });
 
 			params.uniforms.add(ShaderFieldInfo{ "mvp", ShaderFieldType::Matrix4, false, 1 });
 			params.uniforms.add(ShaderFieldInfo{ "tex", ShaderFieldType::Texture, false, 1 });
 			params.uniforms.add(ShaderFieldInfo{ "light_pos", ShaderFieldType::Vec3, false, 1 });
 			params.uniforms.add(ShaderFieldInfo{ "camera_pos", ShaderFieldType::Vec3, false, 1 });
+			params.uniforms.add(ShaderFieldInfo{ "atlas_columns", ShaderFieldType::U32, false, 1 });
+			params.uniforms.add(ShaderFieldInfo{ "camera_chunk", ShaderFieldType::Vec3, false, 1 });
 
 			params.vertex_shader = R"tag(
 #version 460 core
 
-in vec3 pos;
-in vec3 normal;
-in vec2 tex_coord;
-in vec2 tex_offset;
+in uint data;
+in uint chunk;
 
 uniform mat4 mvp;
+uniform uint atlas_columns;
+uniform vec3 camera_chunk;
 
 out vec3 v_pos;
 out vec3 v_normal;
 out vec2 v_tex_coord;
-out vec2 v_tex_offset;
+flat out vec2 v_tex_offset;
+flat out float v_light;
+
+const vec3 normals[6] = vec3[6](
+	vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+	vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+	vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0)
+);
 
 void main()
 {
+	vec3 local_pos = vec3(data & 31u, (data >> 5) & 31u, (data >> 10) & 31u);
+	uint face = (data >> 15) & 7u;
+	uint layer = (data >> 18) & 255u;
+	uint light = (data >> 26) & 15u;
+	// Chunk coordinates are stored modulo 1024, take the one nearest to the camera.
+	ivec3 near = ivec3(camera_chunk);
+	uvec3 bits = uvec3(chunk, chunk >> 10, chunk >> 20);
+	ivec3 chunk_pos = near + (ivec3((bits - uvec3(near)) << 22) >> 22);
+	vec3 pos = vec3(chunk_pos * 16) + local_pos;
+
+	// Same texture orientation per face as the old per vertex coordinates, up to whole tiles.
+	vec2 tex_coord;
+	if      (face == 0u) tex_coord = vec2( local_pos.z, -local_pos.y);
+	else if (face == 1u) tex_coord = vec2(-local_pos.z, -local_pos.y);
+	else if (face == 2u) tex_coord = vec2( local_pos.x, -local_pos.z);
+	else if (face == 3u) tex_coord = vec2( local_pos.x,  local_pos.z);
+	else if (face == 4u) tex_coord = vec2(-local_pos.x, -local_pos.y);
+	else                 tex_coord = vec2( local_pos.x, -local_pos.y);
+
 	gl_Position = mvp * vec4(pos, 1.0);
 	v_pos = pos;
-	v_normal = normal;
+	v_normal = normals[face];
 	v_tex_coord = tex_coord;
-	v_tex_offset = tex_offset;
+	v_tex_offset = vec2(layer % atlas_columns, layer / atlas_columns);
+	// Each level down is a fifth darker, level 0 keeps a little ambient light.
+	v_light = 0.05 + 0.95 * pow(0.8, float(15u - light));
 }
 )tag";
 
@@ -405,36 +621,48 @@ void main()
 in vec3 v_pos;
 in vec3 v_normal;
 in vec2 v_tex_coord;
-in vec2 v_tex_offset;
+flat in vec2 v_tex_offset;
+flat in float v_light;
 
 out vec4 o_frag_color;
 
 uniform sampler2D tex;
 uniform vec3 light_pos;
 uniform vec3 camera_pos;
+uniform uint atlas_columns;
 
 void main()
 {
+	// Directional shading only tells the faces apart, brightness comes from
+	// the flood filled light baked into the vertices.
 	vec3 light_dir = normalize(light_pos - v_pos);
 	// vec3 view_dir = normalize(camera_pos - v_pos);
 	// vec3 reflect_dir = reflect(-light_dir, v_normal);
 	// float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 1) * 0.5;
 	// vec3 specular = vec3(spec, spec, spec);
 	float diff = min(max(dot(v_normal, light_dir), 0.0) + 0.4, 1.0);
-	vec4 obj_color = textureGrad(tex, v_tex_offset + fract(v_tex_coord), dFdx(v_tex_coord), dFdy(v_tex_coord));
+	// Tiles are square, the atlas is atlas_columns tiles wide and as many high.
+	float tile = 1.0 / float(atlas_columns);
+	vec4 obj_color = textureGrad(tex, (v_tex_offset + fract(v_tex_coord)) * tile, dFdx(v_tex_coord) * tile, dFdy(v_tex_coord) * tile);
 	// o_frag_color = vec4((diff + specular) * obj_color.xyz, obj_color.w);
 	// o_frag_color = vec4(pow(diff * obj_color.xyz, vec3(1.0/2.2)), obj_color.w);
-	o_frag_color = vec4(diff * obj_color.xyz, obj_color.w);
+	o_frag_color = vec4(diff * v_light * obj_color.xyz, obj_color.w);
 }
 )tag";
 			{
 				auto material = window->get_graphics().create_material(params);
+				// Block atlas, see MaterialManager. Dirt is the only tile so far,
+				// lamps share it and stand out by their light.
 				auto img = std::make_shared<Image>(Image::load_sync("../data/images/dirt.png"));
 				material->uniforms[0] = mat4::identity();
 				material->uniforms[1] = ShaderFieldTexture_t{ std::move(img) };
 				material->uniforms[2] = vec3{ 100.0f, 300.0f, 100.0f };
 				material->uniforms[3] = input_controller.position;
-				materials.materials.insert({ ItemID::Dirt, std::move(material) });
+				material->uniforms[4] = uint32_t(MaterialManager::ATLAS_COLUMNS);
+				material->uniforms[5] = vec3(math::floor(input_controller.position / (float)Chunk::EDGE_SIZE));
+				materials.block_material = std::move(material);
+				materials.layers[(size_t)ItemID::Dirt] = 0;
+				materials.layers[(size_t)ItemID::Lamp] = 0;
 			}
 		}
 
@@ -444,6 +672,11 @@ void main()
 		window->set_vsync(false);
 #endif // GFXENGINE_EDITOR
 
+		// One directory per seed, so saving one world never replaces the
+		// regions of another.
+		world.seed = (uint32_t)random_seed;
+		world.region_dir = std::filesystem::path("world") / std::to_string(random_seed);
+
 		//world.init_random_chunks(rng, {-world_radius,-world_radius,-world_radius}, {world_radius,world_radius,world_radius}, random_count);
 		world.init(*world_gen, {-world_radius,-world_radius,-world_radius}, {world_radius,world_radius,world_radius});
 	}
@@ -0,0 +1,129 @@
+#include "benchmark.hpp"
+
+#include "gfxengine/platform.hpp"
+#include "gfxengine/noise_generator.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+namespace
+{
+
+// Every benchmark line is also recorded here and written as JSON at the end
+// of the run, so results can be compared across commits.
+struct BenchmarkResult
+{
+	std::string name;
+	std::vector<std::pair<std::string, double>> metrics;
+	int match = -1; // -1 when the benchmark has no check
+};
+
+std::vector<BenchmarkResult> results;
+
+bool write_json(char const *path, int seed)
+{
+	FILE *file = fopen(path, "w");
+	if (!file)
+		return false;
+
+	fprintf(file, "{\n\t\"seed\": %d,\n\t\"benchmarks\": [\n", seed);
+
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		auto const &result = results[i];
+		fprintf(file, "\t\t{ \"name\": \"%s\"", result.name.c_str());
+
+		if (result.match >= 0)
+			fprintf(file, ", \"match\": %s", result.match ? "true" : "false");
+
+		for (auto const &metric : result.metrics)
+			fprintf(file, ", \"%s\": %.17g", metric.first.c_str(), metric.second);
+
+		fprintf(file, " }%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	fprintf(file, "\t]\n}\n");
+	return fclose(file) == 0;
+}
+
+} // namespace
+
+void record(std::string name, std::vector<std::pair<std::string, double>> metrics, int match)
+{
+	results.push_back({ std::move(name), std::move(metrics), match });
+}
+
+void run_app([[maybe_unused]] Platform &platform)
+{
+	const int seed = 1337;
+	const int radius = 4;
+	const int iterations = 50;
+
+	check_vertex_packing();
+	bench_profiler(1000000);
+
+	{
+		NoiseGenerator gen(seed);
+		World world;
+		world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+		report_memory("terrain", world);
+		bench_visible_faces("terrain", world, iterations);
+		bench_greedy_mesh("terrain", world, iterations);
+		bench_quad_emission("terrain quads", world, iterations);
+		bench_chunk_render("terrain render", world, 10);
+		bench_lod_meshes("terrain lod", world, 10);
+		bench_chunk_codec("terrain codec", world, iterations);
+	}
+
+	bench_noise_grid(seed, 8, 10);
+	bench_world_init(seed, 8, 10);
+	bench_thread_pool(2000);
+	bench_tall_terrain(seed, 4, 16, 5);
+	bench_uniform_chunks(seed, 4, 16, 5);
+	check_frustum_culling(seed);
+	check_border_faces(seed, 2);
+	bench_region_files(seed, 8, 10);
+	bench_stream_edits(seed, 500);
+	check_corrupt_chunks(seed);
+	bench_block_edits(seed, 4, 1000);
+	bench_mesh_schedule(seed, 6, 2.0f);
+	bench_chunk_lookups(seed, 8, 100);
+	bench_raycast(seed, 8, 200000);
+	bench_collision(seed, 8, 10000, 300);
+	bench_lighting(seed, 4, 7, 2000);
+
+	for (int density : { 100, 400, 2048 })
+	{
+		World world;
+		double init_ms = measure_ms(10, [&]() {
+			std::mt19937 rng{ (uint32_t)seed };
+			world.init_random_chunks(rng, { -2, -2, -2 }, { 2, 2, 2 }, density);
+		});
+
+		char name[64];
+		snprintf(name, sizeof(name), "random %d", density);
+		printf("%-24s chunks %5d   %8.3f ms/init\n", name, (int)world.chunks.size(), init_ms / 10);
+		record(std::string("random_init/") + name, {
+			{ "chunks", (double)world.chunks.size() },
+			{ "ms_per_init", init_ms / 10 },
+		});
+
+		bench_visible_faces(name, world, iterations);
+		bench_greedy_mesh(name, world, iterations);
+		bench_chunk_render(name, world, 10);
+
+		snprintf(name, sizeof(name), "random %d codec", density);
+		bench_chunk_codec(name, world, iterations);
+	}
+
+	// BLOCKS_BENCHMARK_JSON overrides where the results go.
+	char const *json_path = std::getenv("BLOCKS_BENCHMARK_JSON");
+	if (!json_path)
+		json_path = "benchmark.json";
+
+	if (write_json(json_path, seed))
+		printf("results written to %s\n", json_path);
+	else
+		printf("failed to write %s\n", json_path);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Adds a line of results to the JSON written at the end of the run, match
+// is -1 for benchmarks without a check. See benchmark.cpp.
+void record(std::string name, std::vector<std::pair<std::string, double>> metrics, int match = -1);
+
+template <typename TFunc>
+double measure_ms(int iterations, TFunc &&func)
+{
+	auto t1 = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < iterations; ++i)
+		func();
+
+	auto t2 = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
+
+// benchmark_faces.cpp
+void bench_visible_faces(char const *name, World &world, int iterations);
+void check_border_faces(int seed, int radius);
+
+// benchmark_meshing.cpp
+void bench_greedy_mesh(char const *name, World &world, int iterations);
+void bench_chunk_render(char const *name, World &world, int iterations);
+void bench_lod_meshes(char const *name, World &world, int iterations);
+
+// benchmark_vertices.cpp
+void check_vertex_packing();
+void bench_quad_emission(char const *name, World &world, int iterations);
+
+// benchmark_terrain.cpp
+void report_memory(char const *name, World const &world);
+void bench_world_init(int seed, int radius, int iterations);
+void bench_thread_pool(int loops);
+void bench_noise_grid(int seed, int radius, int iterations);
+void bench_tall_terrain(int seed, int radius, int layers, int iterations);
+void bench_uniform_chunks(int seed, int radius, int layers, int iterations);
+
+// benchmark_profiler.cpp
+void bench_profiler(int iterations);
+
+// benchmark_culling.cpp
+void check_frustum_culling(int seed);
+
+// benchmark_storage.cpp
+void bench_chunk_codec(char const *name, World const &world, int iterations);
+void check_corrupt_chunks(int seed);
+void bench_region_files(int seed, int radius, int iterations);
+void bench_stream_edits(int seed, int edits);
+
+// benchmark_edits.cpp
+void bench_block_edits(int seed, int radius, int edits);
+void bench_mesh_schedule(int seed, int radius, float budget_ms);
+void bench_chunk_lookups(int seed, int radius, int iterations);
+
+// benchmark_raycast.cpp
+void bench_raycast(int seed, int radius, int count);
+
+// benchmark_collision.cpp
+void bench_collision(int seed, int radius, int count, int ticks);
+
+// benchmark_lighting.cpp
+void bench_lighting(int seed, int radius, int layers, int edits);
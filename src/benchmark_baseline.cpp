@@ -0,0 +1,603 @@
+#include "benchmark_baseline.hpp"
+
+#include <algorithm>
+
+namespace baseline
+{
+
+void Frame::add_quad(ItemID id, BlockVertex const &v0, BlockVertex const &v1, BlockVertex const &v2, BlockVertex const &v3)
+{
+	vec3 min = v0.pos;
+	vec3 max = v0.pos;
+
+	for (BlockVertex const *v : { &v1, &v2, &v3 })
+	{
+		min = { std::min(min.x, v->pos.x), std::min(min.y, v->pos.y), std::min(min.z, v->pos.z) };
+		max = { std::max(max.x, v->pos.x), std::max(max.y, v->pos.y), std::max(max.z, v->pos.z) };
+	}
+
+	vec3 n = v0.normal;
+	ChunkQuad quad{};
+	quad.direction =
+		n.x != 0.0f ? (n.x < 0.0f ? Direction::Left : Direction::Right) :
+		n.y != 0.0f ? (n.y < 0.0f ? Direction::Down : Direction::Up) :
+		              (n.z < 0.0f ? Direction::Back : Direction::Front);
+
+	// Faces towards + lie on the far side of their block.
+	quad.pos = ivec3{ (int)min.x, (int)min.y, (int)min.z } - ivec3{ n.x > 0.0f, n.y > 0.0f, n.z > 0.0f };
+	quad.id = id;
+	quad.light = LIGHT_MAX;
+
+	ivec3 size{ int(max.x - min.x), int(max.y - min.y), int(max.z - min.z) };
+
+	switch (quad.direction)
+	{
+	case Direction::Left:
+	case Direction::Right: quad.size_u = size.z; quad.size_v = size.y; break;
+	case Direction::Down:
+	case Direction::Up:    quad.size_u = size.x; quad.size_v = size.z; break;
+	case Direction::Back:
+	case Direction::Front: quad.size_u = size.x; quad.size_v = size.y; break;
+	}
+
+	quads.push_back(quad);
+}
+
+void Chunk::assign(::Chunk const &chunk)
+{
+	for (int x = 0; x < EDGE_SIZE; ++x)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			for (int z = 0; z < EDGE_SIZE; ++z)
+			{
+				ItemID id = chunk.get_block(x, y, z);
+				blocks[x][y][z] = Cube{ id, is_solid(id), {} };
+			}
+		}
+	}
+}
+
+void Chunk::greedy_mesh(std::vector<ChunkQuad> &quads)
+{
+	Frame frame;
+	MaterialManager materials;
+	on_render_no_cache(RenderParams{ frame, materials, ivec3{} });
+	quads.insert(quads.end(), frame.quads.begin(), frame.quads.end());
+}
+
+void Chunk::naive_mesh(std::vector<ChunkQuad> &quads)
+{
+	Frame frame;
+	MaterialManager materials;
+	RenderParams params{ frame, materials, ivec3{} };
+
+	for (int x = 0; x < EDGE_SIZE; ++x)
+		for (int y = 0; y < EDGE_SIZE; ++y)
+			for (int z = 0; z < EDGE_SIZE; ++z)
+				blocks[x][y][z].on_render(params.add_offset({ x, y, z }));
+
+	quads.insert(quads.end(), frame.quads.begin(), frame.quads.end());
+}
+
+// Copied from the first implementation from here on.
+
+void Cube::on_render(RenderParams const &params)
+{
+	if (!solid)
+		return;
+
+	auto material = params.materials.find(id);
+	vec3 p = params.model_offset;
+	vec3 e = p + 1;
+
+	if (visible_faces[(int)Direction::Left])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_x(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_x(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, e.y, e.z }, -vec3::unit_x(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_x(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
+		);
+	}
+
+	if (visible_faces[(int)Direction::Right])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { e.x, p.y, p.z },  vec3::unit_x(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, p.z },  vec3::unit_x(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_x(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, p.y, e.z },  vec3::unit_x(), { 0.0f, 1.0f }, { 0.0f, 0.0f } }
+		);
+	}
+
+	if (visible_faces[(int)Direction::Down])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_y(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_y(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, p.y, e.z }, -vec3::unit_y(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_y(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
+		);
+	}
+
+	if (visible_faces[(int)Direction::Up])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { p.x, e.y, p.z },  vec3::unit_y(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, e.y, e.z },  vec3::unit_y(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_y(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, p.z },  vec3::unit_y(), { 1.0f, 0.0f }, { 0.0f, 0.0f } }
+		);
+	}
+
+	if (visible_faces[(int)Direction::Back])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_z(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_z(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, p.z }, -vec3::unit_z(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_z(), { 0.0f, 1.0f }, { 0.0f, 0.0f } }
+		);
+	}
+
+	if (visible_faces[(int)Direction::Front])
+	{
+		params.frame.add_quad(material,
+			BlockVertex{ { p.x, p.y, e.z },  vec3::unit_z(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, p.y, e.z },  vec3::unit_z(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_z(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
+			BlockVertex{ { p.x, e.y, e.z },  vec3::unit_z(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
+		);
+	}
+}
+
+void Chunk::refresh_visible_faces()
+{
+	dirty = true;
+
+	for (int x = 0; x < EDGE_SIZE; ++x)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			for (int z = 0; z < EDGE_SIZE; ++z)
+			{
+				if (!blocks[x][y][z].solid)
+				{
+					for (int f = 0; f < DIRECTION_MAX; ++f)
+						blocks[x][y][z].visible_faces[f] = false;
+
+					continue;
+				}
+
+				// TODO
+				for (int f = 0; f < DIRECTION_MAX; ++f)
+					blocks[x][y][z].visible_faces[f] = true;
+
+				if (x > 0           && blocks[x-1][y  ][z  ].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Left] = false;
+				if (x < EDGE_SIZE-1 && blocks[x+1][y  ][z  ].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Right] = false;
+				if (y > 0           && blocks[x  ][y-1][z  ].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Down] = false;
+				if (y < EDGE_SIZE-1 && blocks[x  ][y+1][z  ].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Up] = false;
+				if (z > 0           && blocks[x  ][y  ][z-1].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Back] = false;
+				if (z < EDGE_SIZE-1 && blocks[x  ][y  ][z+1].solid)
+					blocks[x][y][z].visible_faces[(int)Direction::Front] = false;
+			}
+		}
+	}
+}
+
+void Chunk::hide_adjacent_chunk_faces(ivec3 delta, Chunk const &other)
+{
+	dirty = true;
+
+	if (delta.x < 0)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+			for (int z = 0; z < EDGE_SIZE; ++z)
+				if (blocks[0][y][z].solid && other.blocks[EDGE_LAST][y][z].solid)
+					blocks[0][y][z].visible_faces[(int)Direction::Left] = false;
+	}
+	else
+	if (delta.x > 0)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+			for (int z = 0; z < EDGE_SIZE; ++z)
+				if (blocks[EDGE_LAST][y][z].solid && other.blocks[0][y][z].solid)
+					blocks[EDGE_LAST][y][z].visible_faces[(int)Direction::Right] = false;
+	}
+	else
+	if (delta.y < 0)
+	{
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int z = 0; z < EDGE_SIZE; ++z)
+				if (blocks[x][0][z].solid && other.blocks[x][EDGE_LAST][z].solid)
+					blocks[x][0][z].visible_faces[(int)Direction::Down] = false;
+	}
+	else
+	if (delta.y > 0)
+	{
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int z = 0; z < EDGE_SIZE; ++z)
+				if (blocks[x][EDGE_LAST][z].solid && other.blocks[x][0][z].solid)
+					blocks[x][EDGE_LAST][z].visible_faces[(int)Direction::Up] = false;
+	}
+	else
+	if (delta.z < 0)
+	{
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int y = 0; y < EDGE_SIZE; ++y)
+				if (blocks[x][y][0].solid && other.blocks[x][y][EDGE_LAST].solid)
+					blocks[x][y][0].visible_faces[(int)Direction::Back] = false;
+	}
+	else
+	if (delta.z > 0)
+	{
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int y = 0; y < EDGE_SIZE; ++y)
+				if (blocks[x][y][EDGE_LAST].solid && other.blocks[x][y][0].solid)
+					blocks[x][y][EDGE_LAST].visible_faces[(int)Direction::Front] = false;
+	}
+}
+
+void Chunk::on_render_no_cache(RenderParams const &params)
+{
+	bool greedy_meshing = true;
+	if (greedy_meshing)
+	{
+		// Left
+		for (int x = 0; x < EDGE_SIZE; ++x)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int z = 0; z < EDGE_SIZE; ++z)
+			{
+				for (int y = 0; y < EDGE_SIZE; ++y)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Left] || meshed[z][y])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ez = z + 1;
+
+					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
+					{
+						if (!blocks[x][y][z2].visible_faces[(int)Direction::Left] || meshed[z2][y])
+							break;
+
+						ez++;
+					}
+
+					int ey = y + 1;
+
+					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
+					{
+						for (int z2 = z; z2 < ez; ++z2)
+							if (!blocks[x][y2][z2].visible_faces[(int)Direction::Left] || meshed[z2][y2])
+								goto _outer_left;
+
+						ey++;
+					}
+					_outer_left:{}
+
+					for (int z2 = z; z2 < ez; ++z2)
+						for (int y2 = y; y2 < ey; ++y2)
+							meshed[z2][y2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x, y, z };
+						ivec3 e = params.model_offset + ivec3{ x, ey, ez };
+						vec2 s = { ez - z, ey - y };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_x(), { c.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_x(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, e.y, e.z }, -vec3::unit_x(), { s.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_x(), { c.x, c.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+
+		// Right
+		for (int x = 0; x < EDGE_SIZE; ++x)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int z = 0; z < EDGE_SIZE; ++z)
+			{
+				for (int y = 0; y < EDGE_SIZE; ++y)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Right] || meshed[z][y])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ez = z + 1;
+
+					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
+					{
+						if (!blocks[x][y][z2].visible_faces[(int)Direction::Right] || meshed[z2][y])
+							break;
+
+						ez++;
+					}
+
+					int ey = y + 1;
+
+					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
+					{
+						for (int z2 = z; z2 < ez; ++z2)
+							if (!blocks[x][y2][z2].visible_faces[(int)Direction::Right] || meshed[z2][y2])
+								goto _outer_right;
+
+						ey++;
+					}
+					_outer_right:{}
+
+					for (int z2 = z; z2 < ez; ++z2)
+						for (int y2 = y; y2 < ey; ++y2)
+							meshed[z2][y2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x+1, y, z };
+						ivec3 e = params.model_offset + ivec3{ x+1, ey, ez };
+						vec2 s = { ez - z, ey - y };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { e.x, p.y, p.z },  vec3::unit_x(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, p.z },  vec3::unit_x(), { s.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_x(), { c.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, p.y, e.z },  vec3::unit_x(), { c.x, s.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+
+		// Down
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int x = 0; x < EDGE_SIZE; ++x)
+			{
+				for (int z = 0; z < EDGE_SIZE; ++z)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Down] || meshed[x][z])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ex = x + 1;
+
+					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
+					{
+						if (!blocks[x2][y][z].visible_faces[(int)Direction::Down] || meshed[x2][z])
+							break;
+
+						ex++;
+					}
+
+					int ez = z + 1;
+
+					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
+					{
+						for (int x2 = x; x2 < ex; ++x2)
+							if (!blocks[x2][y][z2].visible_faces[(int)Direction::Down] || meshed[x2][z2])
+								goto _outer_down;
+
+						ez++;
+					}
+					_outer_down:{}
+
+					for (int x2 = x; x2 < ex; ++x2)
+						for (int z2 = z; z2 < ez; ++z2)
+							meshed[x2][z2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x, y, z };
+						ivec3 e = params.model_offset + ivec3{ ex, y, ez };
+						vec2 s = { ex - x, ez - z };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_y(), { c.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_y(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, p.y, e.z }, -vec3::unit_y(), { s.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_y(), { c.x, c.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+
+		// Up
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int x = 0; x < EDGE_SIZE; ++x)
+			{
+				for (int z = 0; z < EDGE_SIZE; ++z)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Up] || meshed[x][z])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ex = x + 1;
+
+					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
+					{
+						if (!blocks[x2][y][z].visible_faces[(int)Direction::Up] || meshed[x2][z])
+							break;
+
+						ex++;
+					}
+
+					int ez = z + 1;
+
+					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
+					{
+						for (int x2 = x; x2 < ex; ++x2)
+							if (!blocks[x2][y][z2].visible_faces[(int)Direction::Up] || meshed[x2][z2])
+								goto _outer_up;
+
+						ez++;
+					}
+					_outer_up:{}
+
+					for (int x2 = x; x2 < ex; ++x2)
+						for (int z2 = z; z2 < ez; ++z2)
+							meshed[x2][z2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x, y+1, z };
+						ivec3 e = params.model_offset + ivec3{ ex, y+1, ez };
+						vec2 s = { ex - x, ez - z };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { p.x, e.y, p.z },  vec3::unit_y(), { c.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, e.y, e.z },  vec3::unit_y(), { c.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_y(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, p.z },  vec3::unit_y(), { s.x, c.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+
+		// Back
+		for (int z = 0; z < EDGE_SIZE; ++z)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int x = 0; x < EDGE_SIZE; ++x)
+			{
+				for (int y = 0; y < EDGE_SIZE; ++y)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Back] || meshed[x][y])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ex = x + 1;
+
+					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
+					{
+						if (!blocks[x2][y][z].visible_faces[(int)Direction::Back] || meshed[x2][y])
+							break;
+
+						ex++;
+					}
+
+					int ey = y + 1;
+
+					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
+					{
+						for (int x2 = x; x2 < ex; ++x2)
+							if (!blocks[x2][y2][z].visible_faces[(int)Direction::Back] || meshed[x2][y2])
+								goto _outer_back;
+
+						ey++;
+					}
+					_outer_back:{}
+
+					for (int x2 = x; x2 < ex; ++x2)
+						for (int y2 = y; y2 < ey; ++y2)
+							meshed[x2][y2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x, y, z };
+						ivec3 e = params.model_offset + ivec3{ ex, ey, z };
+						vec2 s = { ex - x, ey - y };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_z(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_z(), { s.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, p.z }, -vec3::unit_z(), { c.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_z(), { c.x, s.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+
+		// Front
+		for (int z = 0; z < EDGE_SIZE; ++z)
+		{
+			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+
+			for (int x = 0; x < EDGE_SIZE; ++x)
+			{
+				for (int y = 0; y < EDGE_SIZE; ++y)
+				{
+					if (!blocks[x][y][z].visible_faces[(int)Direction::Front] || meshed[x][y])
+						continue;
+
+					ItemID id = blocks[x][y][z].id;
+
+					int ex = x + 1;
+
+					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
+					{
+						if (!blocks[x2][y][z].visible_faces[(int)Direction::Front] || meshed[x2][y])
+							break;
+
+						ex++;
+					}
+
+					int ey = y + 1;
+
+					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
+					{
+						for (int x2 = x; x2 < ex; ++x2)
+							if (!blocks[x2][y2][z].visible_faces[(int)Direction::Front] || meshed[x2][y2])
+								goto _outer_forward;
+
+						ey++;
+					}
+					_outer_forward:{}
+
+					for (int x2 = x; x2 < ex; ++x2)
+						for (int y2 = y; y2 < ey; ++y2)
+							meshed[x2][y2] = true;
+
+					{
+						ivec3 p = params.model_offset + ivec3{ x, y, z+1 };
+						ivec3 e = params.model_offset + ivec3{ ex, ey, z+1 };
+						vec2 s = { ex - x, ey - y };
+						vec2 c = { 0.0f, 0.0f };
+
+						params.frame.add_quad(params.materials.find(id),
+							BlockVertex{ { p.x, p.y, e.z },  vec3::unit_z(), { c.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, p.y, e.z },  vec3::unit_z(), { s.x, s.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_z(), { s.x, c.y }, { 0.0f, 0.0f } },
+							BlockVertex{ { p.x, e.y, e.z },  vec3::unit_z(), { c.x, c.y }, { 0.0f, 0.0f } }
+						);
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int y = 0; y < EDGE_SIZE; ++y)
+				for (int z = 0; z < EDGE_SIZE; ++z)
+					blocks[x][y][z].on_render(params.add_offset({ x, y, z }));
+	}
+}
+
+} // namespace baseline
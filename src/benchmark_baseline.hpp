@@ -0,0 +1,85 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <vector>
+
+// Face culling and meshing of the first chunk implementation, before the row
+// masks and the binary mesher, kept as the reference the benchmarks check
+// the current code against. Chunk and Cube functions are copied unchanged
+// from it. The types around them only stand in for the ones they drew
+// through, so quads are collected as ChunkQuads instead of drawn.
+namespace baseline
+{
+
+// The old vertex layout, read back into ChunkQuads by Frame.
+struct BlockVertex
+{
+	vec3 pos;
+	vec3 normal;
+	vec2 tex_coord;
+	vec2 tex_offset;
+};
+
+// Collects the quads that used to go to the frame.
+struct Frame
+{
+	std::vector<ChunkQuad> quads;
+
+	void add_quad(ItemID id, BlockVertex const &v0, BlockVertex const &v1, BlockVertex const &v2, BlockVertex const &v3);
+};
+
+// Materials were looked up per quad, quads keep the ItemID instead.
+struct MaterialManager
+{
+	ItemID find(ItemID id) const
+	{
+		return id;
+	}
+};
+
+struct RenderParams
+{
+	Frame &frame;
+	MaterialManager const &materials;
+	ivec3 model_offset;
+
+	RenderParams add_offset(ivec3 offset) const
+	{
+		RenderParams result(*this);
+		result.model_offset += offset;
+		return result;
+	}
+};
+
+struct Cube
+{
+	ItemID id;
+	bool solid;
+	bool visible_faces[DIRECTION_MAX];
+
+	void on_render(RenderParams const &params);
+};
+
+struct Chunk
+{
+	static const size_t EDGE_SIZE = 16;
+	static const size_t EDGE_LAST = EDGE_SIZE - 1;
+	Cube blocks[EDGE_SIZE][EDGE_SIZE][EDGE_SIZE]{};
+
+	bool dirty = false;
+
+	// Copies the blocks of chunk, faces are left for refresh_visible_faces.
+	void assign(::Chunk const &chunk);
+
+	void refresh_visible_faces();
+	void hide_adjacent_chunk_faces(ivec3 delta, Chunk const &other);
+	void on_render_no_cache(RenderParams const &params);
+
+	// Quads of on_render_no_cache, which always meshed greedily.
+	void greedy_mesh(std::vector<ChunkQuad> &quads);
+	// Quads of the per-block path on_render_no_cache had besides.
+	void naive_mesh(std::vector<ChunkQuad> &quads);
+};
+
+} // namespace baseline
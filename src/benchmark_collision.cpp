@@ -0,0 +1,173 @@
+#include "benchmark.hpp"
+#include "collision.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+
+// Collision::move testing every block of the swept region with is_solid_block.
+CollisionMove move_per_block(World const &world, Aabb const &box, vec3 delta)
+{
+	float lo[3]{ box.min.x, box.min.y, box.min.z };
+	float hi[3]{ box.max.x, box.max.y, box.max.z };
+	float wanted[3]{ delta.x, delta.y, delta.z };
+	float applied[3]{};
+
+	CollisionMove result;
+
+	for (int axis : { 1, 0, 2 })
+	{
+		float d = wanted[axis];
+		applied[axis] = d;
+
+		int from[3];
+		int to[3];
+
+		for (int a = 0; a < 3; ++a)
+		{
+			from[a] = (int)std::floor(lo[a]);
+			to[a] = (int)std::ceil(hi[a]) - 1;
+		}
+
+		int first = d > 0.0f ? (int)std::floor(hi[axis]) : (int)std::ceil(lo[axis]) - 1;
+		int last = d > 0.0f ? (int)std::ceil(hi[axis] + d) - 1 : (int)std::floor(lo[axis] + d);
+		int step = d > 0.0f ? 1 : -1;
+
+		for (int cell = first; d != 0.0f && cell != last + step; cell += step)
+		{
+			bool solid = false;
+			from[axis] = to[axis] = cell;
+
+			for (int x = from[0]; x <= to[0]; ++x)
+				for (int y = from[1]; y <= to[1]; ++y)
+					for (int z = from[2]; z <= to[2]; ++z)
+						solid = solid || world.is_solid_block({ x, y, z });
+
+			if (solid)
+			{
+				applied[axis] = d > 0.0f
+					? std::clamp(float(cell) - hi[axis] - Collision::SKIN, 0.0f, d)
+					: std::clamp(float(cell + 1) - lo[axis] + Collision::SKIN, d, 0.0f);
+				break;
+			}
+		}
+
+		lo[axis] += applied[axis];
+		hi[axis] += applied[axis];
+
+		if (applied[axis] != d)
+			result.blocked |= 1 << (axis * 2 + (d > 0.0f ? 1 : 0));
+	}
+
+	result.delta = { applied[0], applied[1], applied[2] };
+	return result;
+}
+
+} // namespace
+
+void bench_collision(int seed, int radius, int count, int ticks)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -radius, 0, -radius }, { radius, 4, radius });
+
+	struct Entity
+	{
+		Aabb box;
+		vec3 velocity;
+		bool on_ground = false;
+	};
+
+	// Player sized boxes dropped on the terrain, walking around and jumping
+	// and turning around when blocked or near the edge of the world.
+	std::mt19937 rng{ (uint32_t)seed };
+	float extent = radius * (float)Chunk::EDGE_SIZE - 4.0f;
+	std::uniform_real_distribution<float> horizontal(-extent, extent);
+	std::uniform_real_distribution<float> speed(-4.0f, 4.0f);
+
+	std::vector<Entity> start(count);
+	for (auto &entity : start)
+	{
+		vec3 feet{ horizontal(rng), 70.0f, horizontal(rng) };
+		entity.box = { feet - vec3{ 0.3f, 0.0f, 0.3f }, feet + vec3{ 0.3f, 1.8f, 0.3f } };
+		entity.velocity = { speed(rng), 0.0f, speed(rng) };
+	}
+
+	const float dt = 1.0f / 60.0f;
+
+	auto simulate = [&](std::vector<Entity> &entities, auto &&move) {
+		for (int tick = 0; tick < ticks; ++tick)
+		{
+			for (size_t i = 0; i < entities.size(); ++i)
+			{
+				Entity &entity = entities[i];
+
+				if (entity.on_ground && (tick + i) % 97 == 0)
+					entity.velocity.y = 9.0f;
+
+				entity.velocity.y -= 28.0f * dt;
+
+				CollisionMove result = move(world, entity.box, entity.velocity * dt);
+				entity.box.min += result.delta;
+				entity.box.max += result.delta;
+
+				entity.on_ground = result.blocked & (1 << (int)Direction::Down);
+				if (result.blocked & (1 << (int)Direction::Down | 1 << (int)Direction::Up))
+					entity.velocity.y = 0.0f;
+
+				if ((result.blocked & (1 << (int)Direction::Left | 1 << (int)Direction::Right)) || std::abs(entity.box.min.x) > extent)
+					entity.velocity.x = entity.box.min.x > 0.0f ? -std::abs(entity.velocity.x) : std::abs(entity.velocity.x);
+				if ((result.blocked & (1 << (int)Direction::Back | 1 << (int)Direction::Front)) || std::abs(entity.box.min.z) > extent)
+					entity.velocity.z = entity.box.min.z > 0.0f ? -std::abs(entity.velocity.z) : std::abs(entity.velocity.z);
+			}
+		}
+	};
+
+	std::vector<Entity> reference = start;
+	double reference_ms = measure_ms(1, [&]() {
+		simulate(reference, move_per_block);
+	});
+
+	std::vector<Entity> entities = start;
+	double ms = measure_ms(1, [&]() {
+		simulate(entities, Collision::move);
+	});
+
+	size_t grounded = 0;
+	bool match = true;
+
+	for (int i = 0; i < count; ++i)
+	{
+		grounded += entities[i].on_ground;
+		match = match &&
+			entities[i].box.min == reference[i].box.min &&
+			entities[i].box.max == reference[i].box.max &&
+			!Collision::overlaps(world, entities[i].box);
+	}
+
+	double moves = double(count) * ticks;
+
+	printf("%-24s entities %6d   ticks %4d   grounded %6d   per block %8.3f ns/move   rows %8.3f ns/move   %8.3f ms/tick   %s\n",
+		"collision",
+		count,
+		ticks,
+		(int)grounded,
+		reference_ms * 1e6 / moves,
+		ms * 1e6 / moves,
+		ms / ticks,
+		match ? "match" : "MISMATCH");
+
+	record("collision", {
+		{ "entities", (double)count },
+		{ "ticks", (double)ticks },
+		{ "per_block_ns_per_move", reference_ms * 1e6 / moves },
+		{ "ns_per_move", ms * 1e6 / moves },
+		{ "ms_per_tick", ms / ticks },
+	}, match);
+}
@@ -0,0 +1,51 @@
+#include "benchmark.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <cstdio>
+
+void check_frustum_culling(int seed)
+{
+	// Camera above the terrain looking along +x, as in the application.
+	vec3 camera_pos = { 0.0f, 40.0f, 0.0f };
+	const mat4 proj = math::perspective(math::deg_to_rad(90.0f), 16.0f / 9.0f, 0.01f, 1000.0f);
+	const mat4 view = math::look_at(camera_pos, camera_pos + vec3::unit_x(), vec3::unit_y());
+	const Frustum frustum = Frustum::from_matrix(proj * view);
+
+	bool match =
+		 frustum.intersects({   10.0f,  38.0f,  -1.0f }, {   12.0f,  42.0f,   1.0f }) && // ahead
+		!frustum.intersects({  -12.0f,  38.0f,  -1.0f }, {  -10.0f,  42.0f,   1.0f }) && // behind
+		!frustum.intersects({    1.0f, 100.0f,  -1.0f }, {    2.0f, 101.0f,   1.0f }) && // straight up
+		!frustum.intersects({ 1100.0f,  38.0f,  -1.0f }, { 1102.0f,  42.0f,   1.0f }) && // past far plane
+		 frustum.intersects({  -50.0f, -50.0f, -50.0f }, {   50.0f,  50.0f,  50.0f });   // around camera
+
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -8, -8, -8 }, { 8, 8, 8 });
+
+	size_t visible = 0;
+	size_t culled = 0;
+
+	for (auto &chunk : world.chunks)
+	{
+		if (chunk.second->is_visible(frustum, chunk.first))
+			visible += 1;
+		else
+			culled += 1;
+
+		// Chunks fully behind the camera must never be drawn.
+		if (chunk.first.x < -1 && chunk.second->is_visible(frustum, chunk.first))
+			match = false;
+	}
+
+	printf("%-24s visible %5d   culled %5d   %s\n",
+		"frustum culling",
+		(int)visible,
+		(int)culled,
+		match ? "match" : "MISMATCH");
+
+	record("frustum_culling", {
+		{ "visible", (double)visible },
+		{ "culled", (double)culled },
+	}, match);
+}
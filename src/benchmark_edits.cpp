@@ -0,0 +1,246 @@
+#include "benchmark.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+void bench_block_edits(int seed, int radius, int edits)
+{
+	NoiseGenerator gen(seed);
+	MaterialManager materials;
+	World world;
+	world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+	world.mesh_edited_chunks(materials);
+
+	std::mt19937 rng{ (uint32_t)seed };
+	std::uniform_int_distribution<int> horizontal(-radius * (int)Chunk::EDGE_SIZE, radius * (int)Chunk::EDGE_SIZE - 1);
+	std::uniform_int_distribution<int> vertical(0, Chunk::EDGE_LAST);
+
+	std::vector<BlockEdit> batch(edits);
+	for (auto &edit : batch)
+		edit = { { horizontal(rng), vertical(rng), horizontal(rng) }, rng() & 1 ? ItemID::Dirt : ItemID::Air };
+
+	// One edit at a time, each meshed before the next like interactive building.
+	double single_ms = measure_ms(1, [&]() {
+		for (auto const &edit : batch)
+		{
+			world.set_block(edit.pos, edit.id);
+			world.mesh_edited_chunks(materials);
+		}
+	});
+
+	for (auto &edit : batch)
+		edit.id = edit.id == ItemID::Air ? ItemID::Dirt : ItemID::Air;
+
+	// Edited chunks wait for their light, which may take a few frames.
+	size_t touched = 0;
+	size_t frames = 0;
+	double batch_ms = measure_ms(1, [&]() {
+		world.set_blocks(batch);
+		touched = world.edited_chunks.size();
+
+		for (; !world.edited_chunks.empty(); ++frames)
+			world.mesh_edited_chunks(materials);
+	});
+
+	// A block placed and removed again in an air chunk leaves it uniform.
+	bool match = true;
+
+	for (auto const &chunk : world.chunks)
+	{
+		if (chunk.second->is_cold() || chunk.second->blocks.bits != 0 || chunk.second->blocks.palette[0] != ItemID::Air)
+			continue;
+
+		ivec3 pos = chunk.first * (int)Chunk::EDGE_SIZE + ivec3{ 3, 3, 3 };
+		world.set_block(pos, ItemID::Dirt);
+		world.mesh_edited_chunks(materials);
+		world.set_block(pos, ItemID::Air);
+		world.mesh_edited_chunks(materials);
+
+		match = chunk.second->blocks.bits == 0;
+		break;
+	}
+
+	// Incremental solidity has to match a full refresh, and edited chunks
+	// keep no palette entries that no block uses.
+
+	for (auto const &chunk : world.chunks)
+	{
+		Chunk incremental;
+		memcpy(incremental.solid_y, chunk.second->solid_y, sizeof(Chunk::solid_y));
+		memcpy(incremental.solid_z, chunk.second->solid_z, sizeof(Chunk::solid_z));
+
+		chunk.second->refresh_solidity();
+		match = match &&
+			memcmp(incremental.solid_y, chunk.second->solid_y, sizeof(Chunk::solid_y)) == 0 &&
+			memcmp(incremental.solid_z, chunk.second->solid_z, sizeof(Chunk::solid_z)) == 0;
+
+		BlockStorage compacted = chunk.second->blocks;
+		compacted.compact();
+		match = match && compacted.palette.size() == chunk.second->blocks.palette.size();
+	}
+
+	printf("%-24s edits %5d   edit+mesh %8.3f us   batch %8.3f ms for %4d chunks in %d frames   %s\n",
+		"block edits",
+		edits,
+		single_ms * 1000.0 / edits,
+		batch_ms,
+		(int)touched,
+		(int)frames,
+		match ? "match" : "MISMATCH");
+
+	record("block_edits", {
+		{ "edits", (double)edits },
+		{ "edit_mesh_us", single_ms * 1000.0 / edits },
+		{ "batch_ms", batch_ms },
+		{ "batch_chunks", (double)touched },
+		{ "batch_frames", (double)frames },
+	}, match);
+}
+
+void bench_mesh_schedule(int seed, int radius, float budget_ms)
+{
+	NoiseGenerator gen(seed);
+	MaterialManager materials;
+
+	struct Run
+	{
+		size_t chunks = 0;
+		int frames = 0;
+		double max_frame_ms = 0.0;
+		double total_ms = 0.0;
+		bool nearest_first = true;
+	};
+
+	// Remeshing a whole regeneration, everything at once like before the
+	// scheduler and then within budget_ms. Collected meshes stand in for uploads.
+	Run runs[2];
+
+	for (int budgeted = 0; budgeted < 2; ++budgeted)
+	{
+		Run &run = runs[budgeted];
+
+		World world;
+		world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+		world.mesh_budget_ms = budgeted ? budget_ms : 0.0f;
+		world.max_mesh_jobs_in_flight = budgeted ? world.max_mesh_jobs_in_flight : 0;
+		run.chunks = world.chunks.size();
+
+		auto start = std::chrono::steady_clock::now();
+
+		do
+		{
+			auto frame_start = std::chrono::steady_clock::now();
+			auto deadline = std::chrono::steady_clock::time_point::max();
+			if (world.mesh_budget_ms > 0.0f)
+				deadline = frame_start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(world.mesh_budget_ms));
+
+			world.collect_meshes();
+			world.completed_meshes.clear();
+			world.schedule_meshes(vec3{}, nullptr, materials, deadline);
+
+			double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+			run.max_frame_ms = std::max(run.max_frame_ms, frame_ms);
+			run.frames += 1;
+
+			// Leave the workers the rest of the frame.
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		while (world.mesh_jobs_in_flight > 0 || !world.remesh_queue.empty());
+
+		run.total_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		// Versions are handed out in submission order, distances must not decrease.
+		// Chunks without faces are cleared without a job, in any order.
+		std::vector<std::pair<uint64_t, int>> order;
+		for (auto const &chunk : world.chunks)
+			if (world.needs_mesh(chunk.first, *chunk.second))
+				order.emplace_back(chunk.second->mesh_version, chunk.first.x * chunk.first.x + chunk.first.y * chunk.first.y + chunk.first.z * chunk.first.z);
+
+		std::sort(order.begin(), order.end());
+		for (size_t i = 1; i < order.size(); ++i)
+			run.nearest_first = run.nearest_first && order[i - 1].second <= order[i].second;
+	}
+
+	bool match = runs[1].nearest_first;
+
+	printf("%-24s chunks %5d   unbudgeted max %8.3f ms   budget %5.2f ms max %8.3f ms   frames %4d / %4d   total %8.3f / %8.3f ms   %s\n",
+		"mesh schedule",
+		(int)runs[1].chunks,
+		runs[0].max_frame_ms,
+		budget_ms,
+		runs[1].max_frame_ms,
+		runs[0].frames,
+		runs[1].frames,
+		runs[0].total_ms,
+		runs[1].total_ms,
+		match ? "nearest first" : "OUT OF ORDER");
+
+	record("mesh_schedule", {
+		{ "chunks", (double)runs[1].chunks },
+		{ "budget_ms", budget_ms },
+		{ "unbudgeted_max_frame_ms", runs[0].max_frame_ms },
+		{ "budgeted_max_frame_ms", runs[1].max_frame_ms },
+		{ "unbudgeted_frames", (double)runs[0].frames },
+		{ "budgeted_frames", (double)runs[1].frames },
+		{ "unbudgeted_total_ms", runs[0].total_ms },
+		{ "budgeted_total_ms", runs[1].total_ms },
+	}, match);
+}
+
+void bench_chunk_lookups(int seed, int radius, int iterations)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+
+	std::unordered_map<ivec3, Chunk *> map;
+	std::vector<ivec3> positions;
+
+	for (auto const &chunk : world.chunks)
+	{
+		map.emplace(chunk.first, chunk.second.get());
+		positions.push_back(chunk.first);
+	}
+
+	// All 26 neighbours of every chunk, as face hiding and block access across borders do.
+	size_t grid_found = 0;
+	double grid_ms = measure_ms(iterations, [&]() {
+		for (auto pos : positions)
+			for (int x = -1; x <= 1; ++x)
+				for (int y = -1; y <= 1; ++y)
+					for (int z = -1; z <= 1; ++z)
+						if (auto it = world.chunks.find(pos + ivec3{ x, y, z }); it != world.chunks.end())
+							grid_found += it->second->has_solid();
+	});
+
+	size_t map_found = 0;
+	double map_ms = measure_ms(iterations, [&]() {
+		for (auto pos : positions)
+			for (int x = -1; x <= 1; ++x)
+				for (int y = -1; y <= 1; ++y)
+					for (int z = -1; z <= 1; ++z)
+						if (auto it = map.find(pos + ivec3{ x, y, z }); it != map.end())
+							map_found += it->second->has_solid();
+	});
+
+	double lookups = double(positions.size()) * 27 * iterations;
+
+	printf("%-24s chunks %5d   grid %6.2f ns   map %6.2f ns per lookup   speedup %5.2fx   %s\n",
+		"chunk lookups",
+		(int)positions.size(),
+		grid_ms * 1e6 / lookups,
+		map_ms * 1e6 / lookups,
+		map_ms / grid_ms,
+		grid_found == map_found ? "match" : "MISMATCH");
+
+	record("chunk_lookups", {
+		{ "chunks", (double)positions.size() },
+		{ "grid_ns", grid_ms * 1e6 / lookups },
+		{ "map_ns", map_ms * 1e6 / lookups },
+	}, grid_found == map_found);
+}
@@ -0,0 +1,180 @@
+#include "benchmark.hpp"
+#include "benchmark_baseline.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+
+bool same_faces(baseline::Chunk const &reference, Chunk const &chunk)
+{
+	for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+		for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+			for (int z = 0; z < Chunk::EDGE_SIZE; ++z)
+				for (int f = 0; f < DIRECTION_MAX; ++f)
+					if (reference.blocks[x][y][z].visible_faces[f] != chunk.is_face_visible(x, y, z, (Direction)f))
+						return false;
+
+	return true;
+}
+
+} // namespace
+
+void bench_visible_faces(char const *name, World &world, int iterations)
+{
+	std::vector<std::unique_ptr<baseline::Chunk>> references;
+	bool match = true;
+
+	for (auto &chunk : world.chunks)
+	{
+		auto reference = std::make_unique<baseline::Chunk>();
+		reference->assign(*chunk.second);
+		reference->refresh_visible_faces();
+
+		chunk.second->refresh_visible_faces();
+		match = match && same_faces(*reference, *chunk.second);
+		references.push_back(std::move(reference));
+	}
+
+	double legacy_ms = measure_ms(iterations, [&]() {
+		for (auto &reference : references)
+			reference->refresh_visible_faces();
+	});
+
+	double masks_ms = measure_ms(iterations, [&]() {
+		for (auto &chunk : world.chunks)
+			chunk.second->refresh_visible_faces();
+	});
+
+	double chunks = double(world.chunks.size()) * iterations;
+
+	printf("%-24s chunks %5d   legacy %8.3f us/chunk   masks %8.3f us/chunk   speedup %6.2fx   %s\n",
+		name,
+		(int)world.chunks.size(),
+		legacy_ms * 1000.0 / chunks,
+		masks_ms * 1000.0 / chunks,
+		legacy_ms / masks_ms,
+		match ? "match" : "MISMATCH");
+
+	record(std::string("visible_faces/") + name, {
+		{ "chunks", (double)world.chunks.size() },
+		{ "legacy_us_per_chunk", legacy_ms * 1000.0 / chunks },
+		{ "masks_us_per_chunk", masks_ms * 1000.0 / chunks },
+	}, match);
+}
+
+// Faces meshed from the padded snapshot, against per-block checks across
+// chunk borders and against the first implementation hiding the faces of
+// each neighbour in turn. Also streams a chunk in next to meshed ones, they
+// have to be remeshed against it.
+void check_border_faces(int seed, int radius)
+{
+	NoiseGenerator gen(seed);
+	MaterialManager materials;
+	World world;
+	world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+
+	std::unordered_map<ivec3, std::unique_ptr<baseline::Chunk>> references;
+
+	for (auto &chunk : world.chunks)
+	{
+		auto reference = std::make_unique<baseline::Chunk>();
+		reference->assign(*chunk.second);
+		reference->refresh_visible_faces();
+		references[chunk.first] = std::move(reference);
+	}
+
+	for (auto &reference : references)
+	{
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+		{
+			ivec3 delta = direction_offset((Direction)f);
+			if (auto n = references.find(reference.first + delta); n != references.end())
+				reference.second->hide_adjacent_chunk_faces(delta, *n->second);
+		}
+	}
+
+	size_t hidden = 0;
+	bool match = true;
+
+	double ms = measure_ms(1, [&]() {
+		for (auto &chunk : world.chunks)
+		{
+			auto job = world.create_mesh_job(chunk.first, *chunk.second, materials);
+			Chunk meshed;
+			meshed.blocks = job->blocks;
+			meshed.refresh_faces(job->solidity);
+			match = match && same_faces(*references.at(chunk.first), meshed);
+
+			ivec3 origin = chunk.first * (int)Chunk::EDGE_SIZE;
+
+			for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+			{
+				for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+				{
+					for (int z = 0; z < Chunk::EDGE_SIZE; ++z)
+					{
+						ivec3 pos = origin + ivec3{ x, y, z };
+						bool solid = world.is_solid_block(pos);
+
+						for (int f = 0; f < DIRECTION_MAX; ++f)
+						{
+							static const ivec3 offsets[DIRECTION_MAX]{ {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1} };
+							bool covered = world.is_solid_block(pos + offsets[f]);
+							bool visible = meshed.is_face_visible(x, y, z, (Direction)f);
+
+							match = match && visible == (solid && !covered);
+							hidden += solid && covered;
+						}
+					}
+				}
+			}
+		}
+	});
+
+	// Take a chunk out and put it back, its solid neighbours have to remesh.
+	ivec3 pos{ 0, 0, 0 };
+	auto it = world.chunks.find(pos);
+	auto chunk = std::move(it->second);
+	world.chunks.erase(it);
+
+	for (auto &other : world.chunks)
+		other.second->dirty = false;
+
+	world.chunks.emplace(pos, std::move(chunk));
+	world.mark_neighbours_dirty(pos);
+
+	size_t remeshed = 0;
+	for (auto const &other : world.chunks)
+		remeshed += other.second->dirty;
+
+	size_t expected = 0;
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+	{
+		static const ivec3 offsets[DIRECTION_MAX]{ {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1} };
+		if (auto n = world.chunks.find(pos + offsets[f]); n != world.chunks.end() && n->second->has_solid())
+			expected += 1;
+	}
+
+	match = match && remeshed == expected;
+
+	printf("%-24s chunks %5d   hidden faces %8d   remeshed %d   %8.3f ms   %s\n",
+		"border faces",
+		(int)world.chunks.size(),
+		(int)hidden,
+		(int)remeshed,
+		ms,
+		match ? "match" : "MISMATCH");
+
+	record("border_faces", {
+		{ "chunks", (double)world.chunks.size() },
+		{ "hidden_faces", (double)hidden },
+		{ "remeshed", (double)remeshed },
+		{ "ms", ms },
+	}, match);
+}
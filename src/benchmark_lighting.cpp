@@ -0,0 +1,163 @@
+#include "benchmark.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+
+// Light after incremental updates has to match lighting every chunk from scratch.
+bool light_matches_relight(World &world)
+{
+	std::vector<std::vector<uint8_t>> levels;
+
+	for (auto const &chunk : world.chunks)
+	{
+		std::vector<uint8_t> chunk_levels(BlockStorage::VOLUME);
+		for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+			chunk_levels[i] = chunk.second->light.get(i);
+
+		levels.push_back(std::move(chunk_levels));
+	}
+
+	world.light.relight(world);
+
+	bool match = true;
+	size_t c = 0;
+
+	for (auto const &chunk : world.chunks)
+	{
+		for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+			match = match && levels[c][i] == chunk.second->light.get(i);
+
+		c += 1;
+	}
+
+	return match;
+}
+
+} // namespace
+
+void bench_lighting(int seed, int radius, int layers, int edits)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -radius, 0, -radius }, { radius, layers, radius });
+
+	const int relights = 5;
+	double relight_ms = measure_ms(relights, [&]() {
+		world.light.relight(world);
+	});
+
+	// Random edits around the surface, lamps included, each spread to the end.
+	std::mt19937 rng{ (uint32_t)seed };
+	std::uniform_int_distribution<int> horizontal(-radius * (int)Chunk::EDGE_SIZE, radius * (int)Chunk::EDGE_SIZE - 1);
+	std::uniform_int_distribution<int> vertical(world.terrain_height / 4, world.terrain_height + 4);
+
+	std::vector<BlockEdit> batch(edits);
+	for (auto &edit : batch)
+	{
+		uint32_t kind = rng() % 4;
+		edit = { { horizontal(rng), vertical(rng), horizontal(rng) }, kind == 0 ? ItemID::Lamp : kind == 1 ? ItemID::Dirt : ItemID::Air };
+	}
+
+	size_t edit_steps = 0;
+	double edit_ms = measure_ms(1, [&]() {
+		for (auto const &edit : batch)
+		{
+			world.set_block(edit.pos, edit.id);
+			edit_steps += world.light.update(world);
+		}
+	});
+
+	bool match = light_matches_relight(world);
+
+	// Worst cases, each edit undone before the next. A lamp in open air
+	// lights and later clears a diamond of radius LIGHT_MAX, a capped shaft
+	// loses its sky light down to the bottom.
+	struct Case
+	{
+		char const *name;
+		std::vector<BlockEdit> apply;
+		std::vector<BlockEdit> undo;
+	};
+
+	int top = layers * (int)Chunk::EDGE_SIZE;
+	int air_y = std::min(top - LIGHT_MAX - 1, world.terrain_height + LIGHT_MAX + 1);
+	ivec3 shaft{ 5, 0, 5 };
+
+	// Dig the shaft from the top of the world down to the bottom block.
+	for (int y = 1; y < top; ++y)
+		world.set_block({ shaft.x, y, shaft.z }, ItemID::Air);
+	world.light.update(world);
+
+	std::vector<Case> cases{
+		{ "lamp in air", { { { 0, air_y, 0 }, ItemID::Lamp } }, { { { 0, air_y, 0 }, ItemID::Air } } },
+		{ "shaft cap", { { { shaft.x, top - 1, shaft.z }, ItemID::Dirt } }, { { { shaft.x, top - 1, shaft.z }, ItemID::Air } } },
+		{ "block in sky", { { { -20, top - 1, -20 }, ItemID::Dirt } }, { { { -20, top - 1, -20 }, ItemID::Air } } },
+	};
+
+	const int repeats = 20;
+
+	printf("%-24s chunks %5d   relight %8.3f ms   %6.3f us/chunk   edits %5d   %8.3f us/edit   %6.1f steps/edit   %s\n",
+		"lighting",
+		(int)world.chunks.size(),
+		relight_ms / relights,
+		relight_ms * 1000.0 / relights / world.chunks.size(),
+		edits,
+		edit_ms * 1000.0 / edits,
+		double(edit_steps) / edits,
+		match ? "match" : "MISMATCH");
+
+	record("lighting", {
+		{ "chunks", (double)world.chunks.size() },
+		{ "relight_ms", relight_ms / relights },
+		{ "edits", (double)edits },
+		{ "us_per_edit", edit_ms * 1000.0 / edits },
+		{ "steps_per_edit", double(edit_steps) / edits },
+	}, match);
+
+	for (auto const &c : cases)
+	{
+		size_t steps[2]{};
+		double ms[2]{};
+
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (int undo = 0; undo < 2; ++undo)
+			{
+				ms[undo] += measure_ms(1, [&]() {
+					world.set_blocks(undo ? c.undo : c.apply);
+					steps[undo] += world.light.update(world);
+				});
+			}
+		}
+
+		size_t worst = std::max(steps[0], steps[1]) / repeats;
+		bool case_match = light_matches_relight(world);
+
+		char name[64];
+		snprintf(name, sizeof(name), "lighting %s", c.name);
+
+		printf("%-24s apply %8.3f us %6d steps   undo %8.3f us %6d steps   %d frames at %d steps   %s\n",
+			name,
+			ms[0] * 1000.0 / repeats,
+			(int)(steps[0] / repeats),
+			ms[1] * 1000.0 / repeats,
+			(int)(steps[1] / repeats),
+			(int)((worst + world.light_steps_per_frame - 1) / world.light_steps_per_frame),
+			(int)world.light_steps_per_frame,
+			case_match ? "match" : "MISMATCH");
+
+		snprintf(name, sizeof(name), "lighting/%s", c.name);
+		record(name, {
+			{ "apply_us", ms[0] * 1000.0 / repeats },
+			{ "apply_steps", double(steps[0] / repeats) },
+			{ "undo_us", ms[1] * 1000.0 / repeats },
+			{ "undo_steps", double(steps[1] / repeats) },
+		}, case_match);
+	}
+}
@@ -0,0 +1,256 @@
+#include "benchmark.hpp"
+#include "benchmark_baseline.hpp"
+#include "chunk_mesher.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+
+bool same_quads(std::vector<ChunkQuad> const &a, std::vector<ChunkQuad> const &b)
+{
+	if (a.size() != b.size())
+		return false;
+
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (a[i].pos != b[i].pos ||
+			a[i].direction != b[i].direction ||
+			a[i].id != b[i].id ||
+			a[i].size_u != b[i].size_u ||
+			a[i].size_v != b[i].size_v)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t covered_faces(std::vector<ChunkQuad> const &quads)
+{
+	size_t result = 0;
+
+	for (auto const &quad : quads)
+		result += quad.size_u * quad.size_v;
+
+	return result;
+}
+
+} // namespace
+
+void bench_greedy_mesh(char const *name, World &world, int iterations)
+{
+	std::vector<std::unique_ptr<baseline::Chunk>> references;
+	std::vector<ChunkQuad> legacy_quads;
+	std::vector<ChunkQuad> quads;
+	size_t quad_count = 0;
+	size_t face_count = 0;
+	bool match = true;
+
+	for (auto &chunk : world.chunks)
+	{
+		auto reference = std::make_unique<baseline::Chunk>();
+		reference->assign(*chunk.second);
+		reference->refresh_visible_faces();
+
+		legacy_quads.clear();
+		quads.clear();
+		reference->greedy_mesh(legacy_quads);
+		chunk.second->greedy_mesh(quads);
+
+		match = match && same_quads(legacy_quads, quads) && covered_faces(legacy_quads) == covered_faces(quads);
+		quad_count += quads.size();
+		face_count += covered_faces(quads);
+		references.push_back(std::move(reference));
+	}
+
+	double legacy_ms = measure_ms(iterations, [&]() {
+		for (auto &reference : references)
+		{
+			legacy_quads.clear();
+			reference->greedy_mesh(legacy_quads);
+		}
+	});
+
+	double binary_ms = measure_ms(iterations, [&]() {
+		for (auto &chunk : world.chunks)
+		{
+			quads.clear();
+			chunk.second->greedy_mesh(quads);
+		}
+	});
+
+	double chunks = double(world.chunks.size()) * iterations;
+
+	printf("%-24s quads %7d   faces %7d   legacy %8.3f us/chunk   binary %8.3f us/chunk   speedup %6.2fx   %s\n",
+		name,
+		(int)quad_count,
+		(int)face_count,
+		legacy_ms * 1000.0 / chunks,
+		binary_ms * 1000.0 / chunks,
+		legacy_ms / binary_ms,
+		match ? "match" : "MISMATCH");
+
+	record(std::string("greedy_mesh/") + name, {
+		{ "quads", (double)quad_count },
+		{ "faces", (double)face_count },
+		{ "legacy_us_per_chunk", legacy_ms * 1000.0 / chunks },
+		{ "binary_us_per_chunk", binary_ms * 1000.0 / chunks },
+	}, match);
+}
+
+void bench_chunk_render(char const *name, World &world, int iterations)
+{
+	MaterialManager materials;
+	Frame frame;
+	FrameCacheVertices vertices;
+
+	size_t counts[2]{};
+	double ms[2]{};
+
+	for (int greedy = 0; greedy < 2; ++greedy)
+	{
+		ms[greedy] = measure_ms(iterations, [&]() {
+			counts[greedy] = 0;
+
+			for (auto &chunk : world.chunks)
+			{
+				MeshParams params{
+					.frame = frame,
+					.materials = materials,
+					.chunk_pos = chunk.first,
+					.model_offset = ivec3{},
+				};
+
+				frame.reset();
+				vertices.clear();
+				frame.cache(vertices, [&]() {
+					counts[greedy] += chunk.second->on_render_no_cache(params, greedy);
+				});
+			}
+		});
+	}
+
+	// The first implementation meshed the same faces into as many quads.
+	size_t legacy_counts[2]{};
+	auto reference = std::make_unique<baseline::Chunk>();
+	std::vector<ChunkQuad> quads;
+
+	for (auto &chunk : world.chunks)
+	{
+		reference->assign(*chunk.second);
+		reference->refresh_visible_faces();
+
+		quads.clear();
+		reference->naive_mesh(quads);
+		legacy_counts[0] += quads.size();
+
+		quads.clear();
+		reference->greedy_mesh(quads);
+		legacy_counts[1] += quads.size();
+	}
+
+	bool match = legacy_counts[0] == counts[0] && legacy_counts[1] == counts[1];
+	double chunks = double(world.chunks.size()) * iterations;
+
+	printf("%-24s quads %7d / %7d naive   naive %8.3f us/chunk   greedy %8.3f us/chunk   speedup %6.2fx   %s\n",
+		name,
+		(int)counts[1],
+		(int)counts[0],
+		ms[0] * 1000.0 / chunks,
+		ms[1] * 1000.0 / chunks,
+		ms[0] / ms[1],
+		match ? "match" : "MISMATCH");
+
+	record(std::string("chunk_render/") + name, {
+		{ "greedy_quads", (double)counts[1] },
+		{ "naive_quads", (double)counts[0] },
+		{ "naive_us_per_chunk", ms[0] * 1000.0 / chunks },
+		{ "greedy_us_per_chunk", ms[1] * 1000.0 / chunks },
+	}, match);
+}
+
+void bench_lod_meshes(char const *name, World &world, int iterations)
+{
+	MaterialManager materials;
+	Frame frame;
+
+	for (int lod = 0; lod <= Chunk::LOD_MAX; ++lod)
+	{
+		size_t quads = 0;
+		size_t full_quads = 0;
+
+		double ms = measure_ms(iterations, [&]() {
+			quads = 0;
+			full_quads = 0;
+
+			for (auto &chunk : world.chunks)
+			{
+				chunk.second->lod = lod;
+				auto job = world.create_mesh_job(chunk.first, *chunk.second, materials);
+				ChunkMesher::run(*job, frame);
+				chunk.second->mesh_full_quads = job->full_quads; // as upload_mesh does
+				quads += job->quads;
+				full_quads += job->full_quads;
+			}
+		});
+
+		// Borders snapshotted from same lod neighbours against the layers of
+		// the neighbours actually reduced.
+		bool match = true;
+
+		if (lod > 0)
+		{
+			std::unordered_map<ivec3, std::unique_ptr<Chunk>> reduced;
+
+			for (auto &chunk : world.chunks)
+			{
+				auto copy = std::make_unique<Chunk>();
+				copy->blocks = chunk.second->blocks;
+				copy->refresh_solidity();
+				copy->reduce_to_lod(lod);
+				copy->refresh_solidity();
+				reduced[chunk.first] = std::move(copy);
+			}
+
+			for (auto &chunk : world.chunks)
+			{
+				for (int f = 0; f < DIRECTION_MAX; ++f)
+				{
+					auto it = world.chunks.find(chunk.first + direction_offset((Direction)f));
+					if (it == world.chunks.end())
+						continue;
+
+					PaddedSolidity snapshot;
+					PaddedSolidity expected;
+					snapshot.set_border((Direction)f, *it->second, lod);
+					expected.set_border((Direction)f, *reduced[it->first]);
+					match = match && memcmp(&snapshot, &expected, sizeof(PaddedSolidity)) == 0;
+				}
+			}
+		}
+
+		printf("%-24s lod %d   triangles %8d / %8d full   %6.1f%% saved   %8.3f us/chunk   %s\n",
+			name,
+			lod,
+			(int)quads * 2,
+			(int)full_quads * 2,
+			full_quads ? 100.0 * (1.0 - double(quads) / double(full_quads)) : 0.0,
+			ms * 1000.0 / iterations / world.chunks.size(),
+			match ? "match" : "MISMATCH");
+
+		record(std::string("lod_meshes/") + name + "/lod_" + std::to_string(lod), {
+			{ "triangles", (double)quads * 2 },
+			{ "full_triangles", (double)full_quads * 2 },
+			{ "us_per_chunk", ms * 1000.0 / iterations / world.chunks.size() },
+		}, match);
+	}
+
+	for (auto &chunk : world.chunks)
+		chunk.second->lod = 0;
+}
@@ -0,0 +1,80 @@
+#include "benchmark.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+void bench_profiler(int iterations)
+{
+	std::vector<ProfileEvent> events;
+	Profiler::collect(events);
+	events.clear();
+
+	auto scopes = [&]() {
+		for (int i = 0; i < iterations; ++i)
+			ProfileScope scope((ProfileStage)(i % PROFILE_STAGE_MAX));
+	};
+
+	Profiler::enabled = false;
+	double disabled_ms = measure_ms(1, scopes);
+
+	Profiler::enabled = true;
+	double enabled_ms = measure_ms(1, scopes);
+
+	// Only the newest RING_SIZE events of a thread survive without a collect,
+	// minus the one slot a writer could be in the middle of.
+	Profiler::collect(events);
+	bool match = events.size() + 1 >= std::min<size_t>(iterations, Profiler::RING_SIZE) && events.size() <= Profiler::RING_SIZE;
+
+	// Worker threads record while this one collects.
+	const int thread_count = 4;
+	const int per_thread = 100000;
+	std::vector<std::thread> threads;
+	std::atomic<int> running = thread_count;
+
+	for (int t = 0; t < thread_count; ++t)
+	{
+		threads.emplace_back([&]() {
+			for (int i = 0; i < per_thread; ++i)
+				ProfileScope scope(ProfileStage::Mesh);
+
+			running -= 1;
+		});
+	}
+
+	events.clear();
+	while (running > 0)
+		Profiler::collect(events);
+
+	for (auto &thread : threads)
+		thread.join();
+
+	Profiler::collect(events);
+	Profiler::enabled = false;
+
+	size_t mesh_events = 0;
+	for (auto const &event : events)
+	{
+		match = match && event.end_ns >= event.start_ns;
+		mesh_events += event.stage == ProfileStage::Mesh;
+	}
+
+	match = match && mesh_events <= size_t(thread_count) * per_thread;
+
+	printf("%-24s scopes %8d   disabled %6.2f ns   enabled %6.2f ns per scope   threaded %7d / %7d collected   %s\n",
+		"profiler",
+		iterations,
+		disabled_ms * 1e6 / iterations,
+		enabled_ms * 1e6 / iterations,
+		(int)mesh_events,
+		thread_count * per_thread,
+		match ? "match" : "MISMATCH");
+
+	record("profiler", {
+		{ "disabled_ns_per_scope", disabled_ms * 1e6 / iterations },
+		{ "enabled_ns_per_scope", enabled_ms * 1e6 / iterations },
+		{ "threaded_collected", (double)mesh_events },
+	}, match);
+}
@@ -0,0 +1,128 @@
+#include "benchmark.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+
+// Same walk as World::raycast a block at a time, looking up the chunk of every block.
+RaycastHit raycast_per_block(World const &world, vec3 origin, vec3 dir, float max_dist)
+{
+	float const o[3]{ origin.x, origin.y, origin.z };
+	float d[3]{ dir.x, dir.y, dir.z };
+	float length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+
+	int block[3];
+	int step[3];
+	int dominant = 0;
+
+	for (int a = 0; a < 3; ++a)
+	{
+		d[a] /= length;
+		block[a] = (int)std::floor(o[a]);
+		step[a] = d[a] > 0.0f ? 1 : -1;
+
+		if (std::abs(d[a]) > std::abs(d[dominant]))
+			dominant = a;
+	}
+
+	float t = 0.0f;
+	Direction face = (Direction)(dominant * 2 + (step[dominant] > 0 ? 0 : 1));
+
+	while (t <= max_dist)
+	{
+		if (world.is_solid_block({ block[0], block[1], block[2] }))
+			return { true, { block[0], block[1], block[2] }, face, t };
+
+		int axis = 0;
+		float next[3];
+
+		for (int a = 0; a < 3; ++a)
+		{
+			next[a] = d[a] == 0.0f ? INFINITY : (float(step[a] > 0 ? block[a] + 1 : block[a]) - o[a]) * (1.0f / d[a]);
+			if (next[a] < next[axis])
+				axis = a;
+		}
+
+		t = next[axis];
+		block[axis] += step[axis];
+		face = (Direction)(axis * 2 + (step[axis] > 0 ? 0 : 1));
+	}
+
+	return {};
+}
+
+} // namespace
+
+void bench_raycast(int seed, int radius, int count)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -radius, 0, -radius }, { radius, 4, radius });
+
+	// From above the terrain in all directions, most rays leave the world
+	// through empty chunks or hit the surface at a shallow angle.
+	std::mt19937 rng{ (uint32_t)seed };
+	std::uniform_real_distribution<float> horizontal(-radius * (float)Chunk::EDGE_SIZE, radius * (float)Chunk::EDGE_SIZE);
+	std::uniform_real_distribution<float> height(20.0f, 80.0f);
+	std::normal_distribution<float> normal;
+
+	std::vector<Ray> rays(count);
+	for (auto &ray : rays)
+		ray = { { horizontal(rng), height(rng), horizontal(rng) }, { normal(rng), normal(rng), normal(rng) }, 128.0f };
+
+	std::vector<RaycastHit> reference(count);
+	double reference_ms = measure_ms(1, [&]() {
+		for (int i = 0; i < count; ++i)
+			reference[i] = raycast_per_block(world, rays[i].origin, rays[i].dir, rays[i].max_dist);
+	});
+
+	std::vector<RaycastHit> single(count);
+	double single_ms = measure_ms(1, [&]() {
+		for (int i = 0; i < count; ++i)
+			single[i] = world.raycast(rays[i].origin, rays[i].dir, rays[i].max_dist);
+	});
+
+	std::vector<RaycastHit> batched(count);
+	double batched_ms = measure_ms(1, [&]() {
+		world.raycast(rays, batched);
+	});
+
+	size_t hits = 0;
+	bool match = true;
+
+	for (int i = 0; i < count; ++i)
+	{
+		hits += reference[i].hit;
+
+		for (auto const *result : { &single[i], &batched[i] })
+		{
+			match = match &&
+				result->hit == reference[i].hit &&
+				result->block == reference[i].block &&
+				result->face == reference[i].face &&
+				std::abs(result->distance - reference[i].distance) < 1e-3f;
+		}
+	}
+
+	printf("%-24s rays %7d   hits %7d   per block %8.3f Mrays/s   chunk skip %8.3f Mrays/s   batched %8.3f Mrays/s   %s\n",
+		"raycast",
+		count,
+		(int)hits,
+		count / reference_ms / 1000.0,
+		count / single_ms / 1000.0,
+		count / batched_ms / 1000.0,
+		match ? "match" : "MISMATCH");
+
+	record("raycast", {
+		{ "rays", (double)count },
+		{ "hits", (double)hits },
+		{ "per_block_rays_per_s", count / reference_ms * 1000.0 },
+		{ "rays_per_s", count / single_ms * 1000.0 },
+		{ "batched_rays_per_s", count / batched_ms * 1000.0 },
+	}, match);
+}
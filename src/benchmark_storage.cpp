@@ -0,0 +1,257 @@
+#include "benchmark.hpp"
+#include "chunk_codec.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+void bench_chunk_codec(char const *name, World const &world, int iterations)
+{
+	std::vector<std::vector<uint8_t>> encoded(world.chunks.size());
+	std::vector<BlockStorage> decoded(world.chunks.size());
+
+	double encode_ms = measure_ms(iterations, [&]() {
+		size_t i = 0;
+		for (auto const &chunk : world.chunks)
+		{
+			encoded[i].clear();
+			ChunkCodec::encode(chunk.second->blocks, encoded[i++]);
+		}
+	});
+
+	bool match = true;
+	double decode_ms = measure_ms(iterations, [&]() {
+		for (size_t i = 0; i < encoded.size(); ++i)
+			match = ChunkCodec::decode(encoded[i].data(), encoded[i].size(), decoded[i]) && match;
+	});
+
+	size_t encoded_bytes = 0;
+	size_t palette_bytes = 0;
+	size_t i = 0;
+
+	for (auto const &chunk : world.chunks)
+	{
+		encoded_bytes += encoded[i].size();
+		palette_bytes += chunk.second->blocks.data.size() * sizeof(uint64_t) + chunk.second->blocks.palette.size();
+
+		for (size_t b = 0; b < BlockStorage::VOLUME; ++b)
+			if (chunk.second->blocks.get(b) != decoded[i].get(b))
+				match = false;
+
+		i += 1;
+	}
+
+	double dense_mb = double(world.chunks.size() * BlockStorage::VOLUME * sizeof(ItemID)) * iterations / (1024.0 * 1024.0);
+
+	printf("%-24s bytes/chunk %7.1f   ratio %6.1fx dense %5.1fx palette   encode %8.1f MB/s   decode %8.1f MB/s   %s\n",
+		name,
+		double(encoded_bytes) / world.chunks.size(),
+		double(world.chunks.size() * BlockStorage::VOLUME * sizeof(ItemID)) / encoded_bytes,
+		double(palette_bytes) / encoded_bytes,
+		dense_mb / (encode_ms / 1000.0),
+		dense_mb / (decode_ms / 1000.0),
+		match ? "match" : "MISMATCH");
+
+	record(std::string("chunk_codec/") + name, {
+		{ "bytes_per_chunk", double(encoded_bytes) / world.chunks.size() },
+		{ "encode_mb_per_second", dense_mb / (encode_ms / 1000.0) },
+		{ "decode_mb_per_second", dense_mb / (decode_ms / 1000.0) },
+	}, match);
+}
+
+// A cold chunk whose data no longer decodes reads as air, refuses edits
+// and saves its data unchanged instead of as air.
+void check_corrupt_chunks(int seed)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.init(gen, { -2, -2, -2 }, { 2, 2, 2 });
+
+	bool match = false;
+	size_t corrupt_bytes = 0;
+
+	for (auto &chunk : world.chunks)
+	{
+		if (chunk.second->blocks.bits == 0)
+			continue;
+
+		chunk.second->freeze();
+		chunk.second->cold_blocks[0] = 0xff; // no such codec mode
+		std::vector<uint8_t> stored = chunk.second->cold_blocks;
+		corrupt_bytes = stored.size();
+
+		ivec3 origin = chunk.first * (int)Chunk::EDGE_SIZE;
+		match = !chunk.second->thaw() && chunk.second->corrupt && !chunk.second->has_solid();
+		match = match && !world.set_block(origin, ItemID::Lamp) && world.get_block(origin) == ItemID::Air;
+
+		std::vector<uint8_t> saved;
+		chunk.second->encode_blocks(saved);
+		match = match && saved == stored;
+		break;
+	}
+
+	printf("%-24s bytes %5d   %s\n",
+		"corrupt chunk",
+		(int)corrupt_bytes,
+		match ? "match" : "MISMATCH");
+
+	record("corrupt_chunk", {
+		{ "bytes", (double)corrupt_bytes },
+	}, match);
+}
+
+void bench_region_files(int seed, int radius, int iterations)
+{
+	NoiseGenerator gen(seed);
+	auto dir = std::filesystem::temp_directory_path() / "blocks_benchmark_regions";
+	std::filesystem::remove_all(dir);
+
+	World generated;
+	double generate_ms = measure_ms(iterations, [&]() {
+		generated.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+	});
+
+	generated.region_dir = dir;
+	generated.seed = (uint32_t)seed;
+	bool match = generated.save_regions();
+
+	size_t file_bytes = 0;
+	for (auto const &entry : std::filesystem::directory_iterator(dir))
+		file_bytes += entry.file_size();
+
+	// A generator with a different seed, so every chunk has to come from the
+	// region files to match.
+	NoiseGenerator other_gen(seed + 1);
+	World loaded;
+	loaded.region_dir = dir;
+	loaded.seed = (uint32_t)seed;
+
+	double load_ms = measure_ms(iterations, [&]() {
+		loaded.regions.clear();
+		loaded.init(other_gen, { -radius, -radius, -radius }, { radius, radius, radius });
+	});
+
+	match = match && loaded.chunks.size() == generated.chunks.size();
+
+	// A world of the other seed generates everything and ignores the files.
+	World other;
+	other.region_dir = dir;
+	other.seed = (uint32_t)seed + 1;
+	other.init(other_gen, { -radius, -radius, -radius }, { radius, radius, radius });
+
+	match = match && loaded.stream_stats.region_loads > 0;
+	match = match && other.stream_stats.region_loads == 0 && other.chunks.size() == generated.chunks.size();
+
+	for (auto const &chunk : generated.chunks)
+	{
+		auto it = loaded.chunks.find(chunk.first);
+		if (it == loaded.chunks.end())
+		{
+			match = false;
+			continue;
+		}
+
+		for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+			if (chunk.second->blocks.get(i) != it->second->blocks.get(i))
+				match = false;
+	}
+
+	printf("%-24s chunks %5d   file %8.1f KB   generate %8.3f ms   load %8.3f ms   %s\n",
+		"region files",
+		(int)loaded.chunks.size(),
+		file_bytes / 1024.0,
+		generate_ms / iterations,
+		load_ms / iterations,
+		match ? "match" : "MISMATCH");
+
+	record("region_files", {
+		{ "chunks", (double)loaded.chunks.size() },
+		{ "file_bytes", (double)file_bytes },
+		{ "generate_ms", generate_ms / iterations },
+		{ "load_ms", load_ms / iterations },
+	}, match);
+
+	std::filesystem::remove_all(dir);
+}
+
+// Edits survive their chunks being unloaded by stream, first kept in
+// memory, then after save_regions in the region files.
+void bench_stream_edits(int seed, int edits)
+{
+	NoiseGenerator gen(seed);
+	auto dir = std::filesystem::temp_directory_path() / "blocks_benchmark_stream_edits";
+	std::filesystem::remove_all(dir);
+
+	const int view_radius = 2;
+	const int unload_radius = 3;
+	vec3 home{ 8.0f, 40.0f, 8.0f };
+	vec3 away{ 8.0f + 64.0f * Chunk::EDGE_SIZE, 40.0f, 8.0f };
+
+	World world;
+	world.stream_loads_per_frame = 1 << 20;
+	world.stream(gen, home, view_radius, unload_radius);
+
+	std::mt19937 rng{ (uint32_t)seed };
+	std::uniform_int_distribution<int> horizontal(-view_radius * (int)Chunk::EDGE_SIZE, view_radius * (int)Chunk::EDGE_SIZE - 1);
+	std::uniform_int_distribution<int> vertical(0, world.stream_max_y * (int)Chunk::EDGE_SIZE - 1);
+
+	std::unordered_map<ivec3, ItemID> expected;
+	for (int i = 0; i < edits; ++i)
+	{
+		ivec3 pos{ horizontal(rng), vertical(rng), horizontal(rng) };
+		ItemID id = rng() & 1 ? ItemID::Lamp : ItemID::Air;
+
+		if (world.set_block(pos, id))
+			expected[pos] = id;
+	}
+
+	auto edits_kept = [&]() {
+		for (auto const &edit : expected)
+			if (world.get_block(edit.first) != edit.second)
+				return false;
+
+		return true;
+	};
+
+	double unload_ms = measure_ms(1, [&]() {
+		world.stream(gen, away, view_radius, unload_radius);
+	});
+
+	size_t stashed = world.unloaded_edits.size();
+	size_t stashed_bytes = 0;
+	for (auto const &edit : world.unloaded_edits)
+		stashed_bytes += edit.second.size();
+
+	world.stream(gen, home, view_radius, unload_radius);
+	bool match = stashed > 0 && world.unloaded_edits.empty() && edits_kept();
+
+	// Saved edits are not kept in memory again, the region files hold them.
+	world.region_dir = dir;
+	match = match && world.save_regions();
+	world.stream(gen, away, view_radius, unload_radius);
+	match = match && world.unloaded_edits.empty();
+	world.regions.clear();
+	world.stream(gen, home, view_radius, unload_radius);
+	match = match && edits_kept();
+
+	printf("%-24s edits %5d   unloaded with edits %4d chunks %8.1f KB   unload %8.3f ms   %s\n",
+		"stream edits",
+		(int)expected.size(),
+		(int)stashed,
+		stashed_bytes / 1024.0,
+		unload_ms,
+		match ? "match" : "MISMATCH");
+
+	record("stream_edits", {
+		{ "edits", (double)expected.size() },
+		{ "unloaded_chunks", (double)stashed },
+		{ "unloaded_bytes", (double)stashed_bytes },
+		{ "unload_ms", unload_ms },
+	}, match);
+
+	std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,309 @@
+#include "benchmark.hpp"
+#include "noise_grid.hpp"
+#include "parallel.hpp"
+#include "chunk_mesher.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+void report_memory(char const *name, World const &world)
+{
+	auto memory = world.memory_stats();
+
+	printf("%-24s chunks %5d   palette entries %5d   blocks %8.1f KB   dense %8.1f KB   chunks %8.1f KB\n",
+		name,
+		(int)memory.chunks,
+		(int)memory.palette_entries,
+		memory.block_bytes / 1024.0,
+		memory.dense_block_bytes / 1024.0,
+		memory.chunk_bytes / 1024.0);
+
+	record(std::string("memory/") + name, {
+		{ "chunks", (double)memory.chunks },
+		{ "palette_entries", (double)memory.palette_entries },
+		{ "block_bytes", (double)memory.block_bytes },
+		{ "dense_block_bytes", (double)memory.dense_block_bytes },
+		{ "chunk_bytes", (double)memory.chunk_bytes },
+	});
+}
+
+void bench_world_init(int seed, int radius, int iterations)
+{
+	NoiseGenerator gen(seed);
+	size_t hardware = std::thread::hardware_concurrency();
+
+	for (size_t threads : { size_t(1), hardware })
+	{
+		World world;
+		world.thread_count = threads;
+
+		double ms = measure_ms(iterations, [&]() {
+			world.init(gen, { -radius, -radius, -radius }, { radius, radius, radius });
+		});
+
+		double chunks = double(world.chunks.size()) * iterations;
+
+		printf("%-24s threads %3d   chunks %5d   %8.3f ms/init   %10.1f chunks/s\n",
+			"world init",
+			(int)threads,
+			(int)world.chunks.size(),
+			ms / iterations,
+			chunks / (ms / 1000.0));
+
+		record("world_init/threads_" + std::to_string(threads), {
+			{ "chunks", (double)world.chunks.size() },
+			{ "ms_per_init", ms / iterations },
+			{ "chunks_per_second", chunks / (ms / 1000.0) },
+		});
+
+		if (hardware <= 1)
+			break;
+	}
+}
+
+// Short parallel loops like the ones stream runs every frame, on threads
+// started for each loop as before and on a ThreadPool kept between loops.
+void bench_thread_pool(int loops)
+{
+	const size_t thread_count = 4;
+	const size_t count = 64;
+
+	std::atomic<size_t> spawn_sum = 0;
+	std::atomic<size_t> pool_sum = 0;
+
+	double spawn_ms = measure_ms(loops, [&]() {
+		std::atomic<size_t> next = 0;
+
+		auto worker = [&]() {
+			for (size_t i = next++; i < count; i = next++)
+				spawn_sum += i;
+		};
+
+		std::vector<std::thread> threads;
+
+		for (size_t t = 1; t < thread_count; ++t)
+			threads.emplace_back(worker);
+
+		worker();
+
+		for (auto &thread : threads)
+			thread.join();
+	});
+
+	ThreadPool pool(thread_count);
+
+	double pool_ms = measure_ms(loops, [&]() {
+		parallel_for(pool, count, [&](size_t i) {
+			pool_sum += i;
+		});
+	});
+
+	size_t expected = size_t(loops) * (count * (count - 1) / 2);
+	bool match = spawn_sum == expected && pool_sum == expected;
+
+	printf("%-24s threads %3d   loops %6d   spawn %8.3f us/loop   pool %8.3f us/loop   speedup %5.2fx   %s\n",
+		"thread pool",
+		(int)thread_count,
+		loops,
+		spawn_ms * 1000.0 / loops,
+		pool_ms * 1000.0 / loops,
+		spawn_ms / pool_ms,
+		match ? "match" : "MISMATCH");
+
+	record("thread_pool", {
+		{ "threads", (double)thread_count },
+		{ "loops", (double)loops },
+		{ "spawn_us_per_loop", spawn_ms * 1000.0 / loops },
+		{ "pool_us_per_loop", pool_ms * 1000.0 / loops },
+	}, match);
+}
+
+void bench_noise_grid(int seed, int radius, int iterations)
+{
+	NoiseGenerator gen(seed);
+	const double scales[] = { 64.0, 32.0, 16.0 };
+	const int EDGE_SIZE = Chunk::EDGE_SIZE;
+
+	std::vector<ivec3> positions;
+	for (int x = -radius; x < radius; ++x)
+		for (int z = -radius; z < radius; ++z)
+			positions.push_back({ x, 0, z });
+
+	std::vector<NoiseGrid> scalar(positions.size() * 3);
+	std::vector<NoiseGrid> grid(positions.size() * 3);
+
+	// Per column, as terrain generation sampled before.
+	double scalar_ms = measure_ms(iterations, [&]() {
+		for (size_t i = 0; i < positions.size(); ++i)
+			for (int o = 0; o < 3; ++o)
+				for (int _x = 0; _x < EDGE_SIZE; ++_x)
+					for (int _z = 0; _z < EDGE_SIZE; ++_z)
+						scalar[i * 3 + o].values[_x][_z] = gen.noise(
+							(positions[i].x * EDGE_SIZE + _x) / scales[o],
+							(positions[i].z * EDGE_SIZE + _z) / scales[o]);
+	});
+
+	double grid_ms = measure_ms(iterations, [&]() {
+		for (size_t i = 0; i < positions.size(); ++i)
+			for (int o = 0; o < 3; ++o)
+				grid[i * 3 + o].fill(gen, positions[i].x * EDGE_SIZE, positions[i].z * EDGE_SIZE, scales[o]);
+	});
+
+	bool match = true;
+	for (size_t i = 0; i < grid.size(); ++i)
+		match = match && memcmp(scalar[i].values, grid[i].values, sizeof(NoiseGrid::values)) == 0;
+
+	double samples = double(grid.size()) * NoiseGrid::SIZE * NoiseGrid::SIZE * iterations;
+
+	printf("%-24s samples %8d   scalar %8.2f M/s   grid %8.2f M/s   speedup %5.2fx   %s\n",
+		"noise grid",
+		(int)(samples / iterations),
+		samples / (scalar_ms * 1000.0),
+		samples / (grid_ms * 1000.0),
+		scalar_ms / grid_ms,
+		match ? "bit-identical" : "MISMATCH");
+
+	record("noise_grid", {
+		{ "samples", samples / iterations },
+		{ "scalar_samples_per_second", samples / (scalar_ms / 1000.0) },
+		{ "grid_samples_per_second", samples / (grid_ms / 1000.0) },
+	}, match);
+}
+
+void bench_tall_terrain(int seed, int radius, int layers, int iterations)
+{
+	NoiseGenerator gen(seed);
+	World world;
+	world.thread_count = 1;
+	world.terrain_height = layers * Chunk::EDGE_SIZE;
+
+	double init_ms = measure_ms(iterations, [&]() {
+		world.init(gen, { -radius, 0, -radius }, { radius, layers, radius });
+	});
+
+	// Every chunk with its own heightmap and filled block by block.
+	size_t air = 0;
+	size_t solid = 0;
+	bool match = true;
+
+	double reference_ms = measure_ms(1, [&]() {
+		for (auto const &chunk : world.chunks)
+		{
+			ivec3 pos = chunk.first;
+			ColumnHeightmap heightmap = world.generate_heightmap(gen, pos.x, pos.z);
+			Chunk reference;
+
+			for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+				for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+					for (int z = 0; z < Chunk::EDGE_SIZE; ++z)
+						if (pos.y * (int)Chunk::EDGE_SIZE + y < heightmap.heights[x][z])
+							reference.set_block(x, y, z, ItemID::Dirt);
+
+			for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+				match = match && reference.blocks.get(i) == chunk.second->blocks.get(i);
+
+			if (chunk.second->blocks.bits == 0)
+				(chunk.second->blocks.palette[0] == ItemID::Air ? air : solid) += 1;
+		}
+	});
+
+	printf("%-24s chunks %5d   air %5d   solid %5d   init %8.3f ms   per block %8.3f ms   speedup %5.2fx   %s\n",
+		"tall terrain",
+		(int)world.chunks.size(),
+		(int)air,
+		(int)solid,
+		init_ms / iterations,
+		reference_ms,
+		reference_ms * iterations / init_ms,
+		match ? "match" : "MISMATCH");
+
+	record("tall_terrain", {
+		{ "chunks", (double)world.chunks.size() },
+		{ "air_chunks", (double)air },
+		{ "solid_chunks", (double)solid },
+		{ "init_ms", init_ms / iterations },
+		{ "per_block_ms", reference_ms },
+	}, match);
+}
+
+void bench_uniform_chunks(int seed, int radius, int layers, int iterations)
+{
+	NoiseGenerator gen(seed);
+	MaterialManager materials;
+	Frame frame;
+	World world;
+	world.thread_count = 1;
+	world.terrain_height = layers * Chunk::EDGE_SIZE;
+	world.init(gen, { -radius, 0, -radius }, { radius, layers, radius });
+
+	auto memory = world.memory_stats();
+
+	// Every chunk through a mesh job, uniform ones repacked so that they
+	// take the general face pass.
+	std::unordered_map<ivec3, size_t> reference_quads;
+
+	double reference_ms = measure_ms(iterations, [&]() {
+		for (auto &chunk : world.chunks)
+		{
+			auto job = world.create_mesh_job(chunk.first, *chunk.second, materials);
+
+			if (job->blocks.bits == 0)
+			{
+				uint8_t indices[BlockStorage::VOLUME]{};
+				job->blocks.assign({ job->blocks.palette[0], ItemID::Air }, indices);
+			}
+
+			ChunkMesher::run(*job, frame);
+			reference_quads[chunk.first] = job->quads;
+		}
+	});
+
+	size_t jobs = 0;
+	bool match = true;
+
+	double fast_ms = measure_ms(iterations, [&]() {
+		jobs = 0;
+
+		for (auto &chunk : world.chunks)
+		{
+			size_t quads = 0;
+
+			if (world.needs_mesh(chunk.first, *chunk.second))
+			{
+				auto job = world.create_mesh_job(chunk.first, *chunk.second, materials);
+				ChunkMesher::run(*job, frame);
+				quads = job->quads;
+				jobs += 1;
+			}
+
+			match = match && quads == reference_quads[chunk.first];
+		}
+	});
+
+	printf("%-24s chunks %5d   empty %5d   uniform solid %5d   jobs %5d   all %8.3f ms   fast paths %8.3f ms   speedup %5.2fx   %s\n",
+		"uniform chunks",
+		(int)memory.chunks,
+		(int)memory.empty_chunks,
+		(int)memory.uniform_solid_chunks,
+		(int)jobs,
+		reference_ms / iterations,
+		fast_ms / iterations,
+		reference_ms / fast_ms,
+		match ? "match" : "MISMATCH");
+
+	record("uniform_chunks", {
+		{ "chunks", (double)memory.chunks },
+		{ "empty_chunks", (double)memory.empty_chunks },
+		{ "uniform_solid_chunks", (double)memory.uniform_solid_chunks },
+		{ "mesh_jobs", (double)jobs },
+		{ "all_ms", reference_ms / iterations },
+		{ "fast_ms", fast_ms / iterations },
+	}, match);
+}
@@ -0,0 +1,117 @@
+#include "benchmark.hpp"
+
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+void check_vertex_packing()
+{
+	bool match = true;
+
+	for (int x = 0; x <= Chunk::EDGE_SIZE; ++x)
+	{
+		for (int y = 0; y <= Chunk::EDGE_SIZE; ++y)
+		{
+			for (int z = 0; z <= Chunk::EDGE_SIZE; ++z)
+			{
+				for (int f = 0; f < DIRECTION_MAX; ++f)
+				{
+					for (uint32_t light = 0; light <= LIGHT_MAX; ++light)
+					{
+						uint32_t layer = (x * 31 + y * 7 + z) & 0xff;
+						// Far outside the 1024 chunks the field holds, near a camera chunk up to 512 away.
+						ivec3 chunk_pos = { x * 6007 - 50000, 511 - z * 6101, (y - 8) * 60013 };
+						ivec3 camera_chunk = chunk_pos + ivec3{ (z - 8) * 63, (x - 8) * 63, 511 - y * 63 };
+						auto vertex = BlockVertex::pack({ x, y, z }, (Direction)f, layer, chunk_pos, light);
+
+						match = match &&
+							vertex.local_pos() == ivec3{ x, y, z } &&
+							vertex.normal() == (Direction)f &&
+							vertex.layer() == layer &&
+							vertex.light() == light &&
+							vertex.chunk_pos(camera_chunk) == chunk_pos;
+					}
+				}
+			}
+		}
+	}
+
+	printf("%-24s bytes %3d   quad bytes %3d   %s\n",
+		"vertex packing",
+		(int)sizeof(BlockVertex),
+		(int)sizeof(BlockVertex) * 4,
+		match ? "match" : "MISMATCH");
+
+	record("vertex_packing", {
+		{ "bytes", (double)sizeof(BlockVertex) },
+	}, match);
+}
+
+// Quads emitted with a material looked up per quad, as before the block atlas.
+void bench_quad_emission(char const *name, World &world, int iterations)
+{
+	std::vector<std::pair<ivec3, ChunkQuad>> quads;
+
+	for (auto &chunk : world.chunks)
+	{
+		std::vector<ChunkQuad> chunk_quads;
+		chunk.second->greedy_mesh(chunk_quads);
+
+		for (auto const &quad : chunk_quads)
+			quads.push_back({ chunk.first, quad });
+	}
+
+	// Headless, so there is no real material. Aliasing an owned int gives
+	// copies the same refcount traffic.
+	std::shared_ptr<Material> material(std::make_shared<int>(0), nullptr);
+
+	std::unordered_map<ItemID, std::shared_ptr<Material>> legacy_materials{ { ItemID::Dirt, material } };
+	MaterialManager materials;
+	materials.block_material = material;
+
+	Frame frame;
+	FrameCacheVertices vertices;
+
+	double legacy_ms = measure_ms(iterations, [&]() {
+		frame.reset();
+		vertices.clear();
+		frame.cache(vertices, [&]() {
+			for (auto const &[chunk_pos, quad] : quads)
+			{
+				std::shared_ptr<Material> found;
+				if (auto it = legacy_materials.find(quad.id); it != legacy_materials.end())
+					found = it->second;
+
+				BlockVertex v = BlockVertex::pack(quad.pos, quad.direction, 0, chunk_pos);
+				frame.add_quad(found, v, v, v, v);
+			}
+		});
+	});
+
+	double dense_ms = measure_ms(iterations, [&]() {
+		frame.reset();
+		vertices.clear();
+		frame.cache(vertices, [&]() {
+			for (auto const &[chunk_pos, quad] : quads)
+			{
+				BlockVertex v = BlockVertex::pack(quad.pos, quad.direction, materials.layer(quad.id), chunk_pos);
+				frame.add_quad(materials.block_material, v, v, v, v);
+			}
+		});
+	});
+
+	double count = double(quads.size()) * iterations;
+
+	printf("%-24s quads %7d   lookup %6.2f ns/quad   dense %6.2f ns/quad   speedup %5.2fx\n",
+		name,
+		(int)quads.size(),
+		legacy_ms * 1e6 / count,
+		dense_ms * 1e6 / count,
+		legacy_ms / dense_ms);
+
+	record(std::string("quad_emission/") + name, {
+		{ "quads", (double)quads.size() },
+		{ "lookup_ns_per_quad", legacy_ms * 1e6 / count },
+		{ "dense_ns_per_quad", dense_ms * 1e6 / count },
+	});
+}
@@ -1,71 +1,37 @@
 #include "block.hpp"
 
-void Cube::on_render(RenderParams const &params)
+void add_block_quad(MeshParams const &params, Direction direction, ivec3 pos, int size_u, int size_v, ItemID id, uint8_t light)
 {
-	if (!solid)
+	// Corner offsets as multiples of (size_u, size_v), wound to survive back face culling.
+	struct Corner { ivec3 u, v; };
+	static const Corner corners[DIRECTION_MAX][4]{
+		{ { {0,0,0}, {0,0,0} }, { {0,0,1}, {0,0,0} }, { {0,0,1}, {0,1,0} }, { {0,0,0}, {0,1,0} } }, // Left
+		{ { {0,0,0}, {0,0,0} }, { {0,0,0}, {0,1,0} }, { {0,0,1}, {0,1,0} }, { {0,0,1}, {0,0,0} } }, // Right
+		{ { {0,0,0}, {0,0,0} }, { {1,0,0}, {0,0,0} }, { {1,0,0}, {0,0,1} }, { {0,0,0}, {0,0,1} } }, // Down
+		{ { {0,0,0}, {0,0,0} }, { {0,0,0}, {0,0,1} }, { {1,0,0}, {0,0,1} }, { {1,0,0}, {0,0,0} } }, // Up
+		{ { {0,0,0}, {0,0,0} }, { {0,0,0}, {0,1,0} }, { {1,0,0}, {0,1,0} }, { {1,0,0}, {0,0,0} } }, // Back
+		{ { {0,0,0}, {0,0,0} }, { {1,0,0}, {0,0,0} }, { {1,0,0}, {0,1,0} }, { {0,0,0}, {0,1,0} } }, // Front
+	};
+	static const ivec3 outer_offset[DIRECTION_MAX]{ {0,0,0}, {1,0,0}, {0,0,0}, {0,1,0}, {0,0,0}, {0,0,1} };
+
+	ivec3 p = params.model_offset + pos + outer_offset[(int)direction];
+	auto const &c = corners[(int)direction];
+	uint32_t layer = params.materials.layer(id);
+
+	params.frame.add_quad(params.materials.block_material,
+		BlockVertex::pack(p + c[0].u * size_u + c[0].v * size_v, direction, layer, params.chunk_pos, light),
+		BlockVertex::pack(p + c[1].u * size_u + c[1].v * size_v, direction, layer, params.chunk_pos, light),
+		BlockVertex::pack(p + c[2].u * size_u + c[2].v * size_v, direction, layer, params.chunk_pos, light),
+		BlockVertex::pack(p + c[3].u * size_u + c[3].v * size_v, direction, layer, params.chunk_pos, light)
+	);
+}
+
+void Cube::on_render(MeshParams const &params, uint8_t visible_faces, uint8_t const *face_light)
+{
+	if (!is_solid(id))
 		return;
 
-	auto material = params.materials.find(id);
-	vec3 p = params.model_offset;
-	vec3 e = p + 1;
-
-	if (visible_faces[(int)Direction::Left])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_x(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_x(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, e.y, e.z }, -vec3::unit_x(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_x(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
-		);
-	}
-
-	if (visible_faces[(int)Direction::Right])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { e.x, p.y, p.z },  vec3::unit_x(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, p.z },  vec3::unit_x(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_x(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, p.y, e.z },  vec3::unit_x(), { 0.0f, 1.0f }, { 0.0f, 0.0f } }
-		);
-	}
-
-	if (visible_faces[(int)Direction::Down])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_y(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_y(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, p.y, e.z }, -vec3::unit_y(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_y(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
-		);
-	}
-
-	if (visible_faces[(int)Direction::Up])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { p.x, e.y, p.z },  vec3::unit_y(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, e.y, e.z },  vec3::unit_y(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_y(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, p.z },  vec3::unit_y(), { 1.0f, 0.0f }, { 0.0f, 0.0f } }
-		);
-	}
-
-	if (visible_faces[(int)Direction::Back])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_z(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_z(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, p.z }, -vec3::unit_z(), { 0.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_z(), { 0.0f, 1.0f }, { 0.0f, 0.0f } }
-		);
-	}
-
-	if (visible_faces[(int)Direction::Front])
-	{
-		params.frame.add_quad(material,
-			BlockVertex{ { p.x, p.y, e.z },  vec3::unit_z(), { 0.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, p.y, e.z },  vec3::unit_z(), { 1.0f, 1.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { e.x, e.y, e.z },  vec3::unit_z(), { 1.0f, 0.0f }, { 0.0f, 0.0f } },
-			BlockVertex{ { p.x, e.y, e.z },  vec3::unit_z(), { 0.0f, 0.0f }, { 0.0f, 0.0f } }
-		);
-	}
-}
\ No newline at end of file
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+		if (visible_faces & (1 << f))
+			add_block_quad(params, (Direction)f, {}, 1, 1, id, face_light ? face_light[f] : LIGHT_MAX);
+}
@@ -2,36 +2,43 @@
 
 #include "gfxengine/frame.hpp"
 
-#include <unordered_map>
-
 class Graphics;
+struct Frustum;
 
 enum class ItemID : uint8_t
 {
 	Air,
 	Dirt,
+	Lamp,
 };
 
-struct BlockVertex
+static inline const size_t ITEM_ID_MAX = 256;
+
+// Light levels run from 0 (dark) to LIGHT_MAX (open sky or next to a lamp).
+static inline const uint8_t LIGHT_MAX = 15;
+
+struct ItemProperties
 {
-	vec3 pos;
-	vec3 normal;
-	vec2 tex_coord;
-	vec2 tex_offset;
+	bool solid;
+	uint8_t light = 0; // emitted block light level
 };
 
-struct MaterialManager
-{
-	std::unordered_map<ItemID, std::shared_ptr<Material>> materials;
+// Indexed by ItemID, entries past the known ids are zero (not solid).
+static inline const ItemProperties ITEM_PROPERTIES[ITEM_ID_MAX]{
+	{ .solid = false }, // Air
+	{ .solid = true },  // Dirt
+	{ .solid = true, .light = LIGHT_MAX }, // Lamp
+};
 
-	std::shared_ptr<Material> find(ItemID id) const
-	{
-		if (auto it = materials.find(id); it != materials.end())
-			return it->second;
+inline bool is_solid(ItemID id)
+{
+	return ITEM_PROPERTIES[(size_t)id].solid;
+}
 
-		return {};
-	}
-};
+inline uint8_t light_emission(ItemID id)
+{
+	return ITEM_PROPERTIES[(size_t)id].light;
+}
 
 enum class Direction : uint8_t
 {
@@ -45,26 +52,165 @@ enum class Direction : uint8_t
 
 static inline const size_t DIRECTION_MAX = 6;
 
+inline Direction opposite(Direction direction)
+{
+	return (Direction)((int)direction ^ 1);
+}
+
+// Unit step towards direction.
+inline ivec3 direction_offset(Direction direction)
+{
+	ivec3 offset{};
+	int sign = ((int)direction & 1) ? 1 : -1;
+
+	switch (direction)
+	{
+	case Direction::Left:
+	case Direction::Right: offset.x = sign; break;
+	case Direction::Down:
+	case Direction::Up:    offset.y = sign; break;
+	case Direction::Back:
+	case Direction::Front: offset.z = sign; break;
+	}
+
+	return offset;
+}
+
+// Packed chunk vertex, decoded by the block vertex shader.
+// data:  bits  0..4  x, 5..9 y, 10..14 z, chunk local (0..16)
+//        bits 15..17 normal as Direction
+//        bits 18..25 texture layer, tile of the block atlas (see MaterialManager)
+//        bits 26..29 light level in front of the face, max of sky and block light
+// chunk: bits  0..9  x, 10..19 y, 20..29 z, chunk coordinate modulo 1024
+//        The shader restores the rest from the camera chunk (see chunk_pos), so
+//        the world is unbounded and only chunks over 512 chunks from the camera,
+//        far beyond any view distance, would be drawn in the wrong place.
+// Texture coordinates are derived from the position and normal in the shader.
+struct BlockVertex
+{
+	uint32_t data;
+	uint32_t chunk;
+
+	static BlockVertex pack(ivec3 local_pos, Direction normal, uint32_t layer, ivec3 chunk_pos, uint32_t light = LIGHT_MAX)
+	{
+		BlockVertex result;
+		result.data =
+			(uint32_t)local_pos.x |
+			(uint32_t)local_pos.y << 5 |
+			(uint32_t)local_pos.z << 10 |
+			(uint32_t)normal << 15 |
+			(layer & 0xff) << 18 |
+			(light & 0xf) << 26;
+		result.chunk =
+			((uint32_t)chunk_pos.x & 0x3ff) |
+			((uint32_t)chunk_pos.y & 0x3ff) << 10 |
+			((uint32_t)chunk_pos.z & 0x3ff) << 20;
+		return result;
+	}
+
+	ivec3 local_pos() const
+	{
+		return { int(data & 31), int((data >> 5) & 31), int((data >> 10) & 31) };
+	}
+
+	Direction normal() const
+	{
+		return (Direction)((data >> 15) & 7);
+	}
+
+	uint32_t layer() const
+	{
+		return (data >> 18) & 0xff;
+	}
+
+	uint32_t light() const
+	{
+		return (data >> 26) & 0xf;
+	}
+
+	// Of the chunk coordinates the field stands for, the one within 512
+	// chunks of near on each axis.
+	ivec3 chunk_pos(ivec3 near) const
+	{
+		auto restore = [](uint32_t bits, int near) {
+			return near + (int((bits - (uint32_t)near) << 22) >> 22);
+		};
+
+		return { restore(chunk, near.x), restore(chunk >> 10, near.y), restore(chunk >> 20, near.z) };
+	}
+};
+
+static_assert(sizeof(BlockVertex) == 8);
+
+// All blocks are drawn with one material. Its texture is an atlas of
+// ATLAS_COLUMNS tiles per row, left to right and top to bottom, and each
+// vertex picks a tile by its layer. A chunk mesh is a single draw call
+// whatever blocks it holds.
+struct MaterialManager
+{
+	static const uint32_t ATLAS_COLUMNS = 1;
+
+	std::shared_ptr<Material> block_material;
+	uint8_t layers[ITEM_ID_MAX]{}; // atlas tile, indexed by ItemID
+
+	uint32_t layer(ItemID id) const
+	{
+		return layers[(size_t)id];
+	}
+};
+
+// Everything needed to build chunk geometry, safe to use off the render thread.
+struct MeshParams
+{
+	Frame &frame;
+	MaterialManager const &materials;
+	ivec3 chunk_pos;
+	ivec3 model_offset; // chunk local
+
+	MeshParams add_offset(ivec3 offset) const
+	{
+		MeshParams result(*this);
+		result.model_offset += offset;
+		return result;
+	}
+};
+
 struct RenderParams
 {
 	Frame &frame;
 	MaterialManager const &materials;
 	Graphics &graphics;
-	ivec3 model_offset;
+	ivec3 chunk_pos;
+	Frustum const *frustum; // chunks outside are skipped, nullptr draws everything
+	vec3 camera_pos;
 
-	RenderParams add_offset(ivec3 offset) const
+	RenderParams at_chunk(ivec3 pos) const
 	{
 		RenderParams result(*this);
-		result.model_offset += offset;
+		result.chunk_pos = pos;
 		return result;
 	}
+
+	MeshParams mesh_params() const
+	{
+		return MeshParams{
+			.frame = frame,
+			.materials = materials,
+			.chunk_pos = chunk_pos,
+			.model_offset = ivec3{},
+		};
+	}
 };
 
+// Adds one axis aligned quad of size_u by size_v blocks facing direction,
+// see ChunkQuad for which axes u and v map to.
+void add_block_quad(MeshParams const &params, Direction direction, ivec3 pos, int size_u, int size_v, ItemID id, uint8_t light = LIGHT_MAX);
+
 struct Cube
 {
 	ItemID id;
-	bool solid;
-	bool visible_faces[DIRECTION_MAX];
 
-	void on_render(RenderParams const &params);
+	// visible_faces: one bit per Direction, see Chunk::visible_faces
+	// face_light: light level per Direction, nullptr for fully lit faces
+	void on_render(MeshParams const &params, uint8_t visible_faces, uint8_t const *face_light = nullptr);
 };
@@ -0,0 +1,180 @@
+#include "block_storage.hpp"
+
+#include <cstring>
+
+void BlockStorage::set(size_t index, ItemID id)
+{
+	uint32_t value = 0;
+
+	while (value < palette.size() && palette[value] != id)
+		++value;
+
+	if (value == palette.size())
+	{
+		palette.push_back(id);
+
+		if (palette.size() > (1ull << bits))
+			resize_bits(bits == 0 ? 1 : bits * 2);
+	}
+
+	set_palette_index(index, value);
+}
+
+void BlockStorage::fill(ItemID id)
+{
+	palette.assign(1, id);
+	data.clear();
+	data.shrink_to_fit();
+	bits = 0;
+}
+
+void BlockStorage::compact()
+{
+	if (bits == 0)
+		return;
+
+	// Edited chunks are compacted every frame, most keep all their entries.
+	// Unused ones are found a word at a time, before any index is moved.
+	bool used[256]{};
+
+	if (bits == 1)
+	{
+		for (uint64_t word : data)
+		{
+			used[0] = used[0] || word != ~0ull;
+			used[1] = used[1] || word != 0;
+		}
+	}
+	else
+	{
+		uint64_t mask = (1ull << bits) - 1;
+
+		for (uint64_t word : data)
+			for (int shift = 0; shift < 64; shift += bits)
+				used[(word >> shift) & mask] = true;
+	}
+
+	uint8_t remap[256];
+	std::vector<ItemID> new_palette;
+
+	for (size_t i = 0; i < palette.size(); ++i)
+	{
+		if (used[i])
+		{
+			remap[i] = (uint8_t)new_palette.size();
+			new_palette.push_back(palette[i]);
+		}
+	}
+
+	if (new_palette.size() == palette.size())
+		return;
+
+	if (new_palette.size() == 1)
+	{
+		fill(new_palette[0]);
+		return;
+	}
+
+	uint8_t indices[VOLUME];
+	for (size_t i = 0; i < VOLUME; ++i)
+		indices[i] = remap[palette_index(i)];
+
+	assign(std::move(new_palette), indices);
+	data.shrink_to_fit();
+}
+
+size_t BlockStorage::memory_usage() const
+{
+	return sizeof(*this) + palette.capacity() * sizeof(ItemID) + data.capacity() * sizeof(uint64_t);
+}
+
+// Squeezes eight bytes holding BITS wide values into the low 8 * BITS bits,
+// halving the gaps between values in three steps.
+template <int BITS>
+static uint64_t gather_bytes(uint64_t v)
+{
+	for (int step = 0; step < 3; ++step)
+	{
+		int lane = 16 << step;
+		int keep = (2 * BITS) << step;
+		uint64_t lane_mask = keep >= 64 ? ~0ull : (1ull << keep) - 1;
+
+		uint64_t mask = 0;
+		for (int i = 0; i < 64; i += lane)
+			mask |= lane_mask << i;
+
+		v = (v | (v >> ((8 - BITS) << step))) & mask;
+	}
+
+	return v;
+}
+
+// BITS divides 64, indices are read eight at a time (little endian).
+template <int BITS>
+static void pack_indices(uint64_t *words, uint8_t const *indices)
+{
+	const size_t per_word = 64 / BITS;
+
+	for (size_t w = 0; w < BlockStorage::VOLUME / per_word; ++w)
+	{
+		uint64_t word = 0;
+
+		for (size_t group = 0; group < 8 / BITS; ++group)
+		{
+			uint64_t bytes;
+			memcpy(&bytes, indices + w * per_word + group * 8, sizeof(bytes));
+			word |= gather_bytes<BITS>(bytes) << (group * 8 * BITS);
+		}
+
+		words[w] = word;
+	}
+}
+
+void BlockStorage::assign(std::vector<ItemID> new_palette, uint8_t const indices[VOLUME])
+{
+	palette = std::move(new_palette);
+	bits = 0;
+
+	while (palette.size() > (1ull << bits))
+		bits = bits == 0 ? 1 : bits * 2;
+
+	data.resize(VOLUME * bits / 64);
+
+	switch (bits)
+	{
+	case 1: pack_indices<1>(data.data(), indices); break;
+	case 2: pack_indices<2>(data.data(), indices); break;
+	case 4: pack_indices<4>(data.data(), indices); break;
+	case 8: pack_indices<8>(data.data(), indices); break;
+	}
+}
+
+void BlockStorage::set_palette_index(size_t index, uint32_t value)
+{
+	if (bits == 0)
+		return;
+
+	size_t bit = index * bits;
+	uint64_t mask = uint64_t((1u << bits) - 1) << (bit & 63);
+	uint64_t &word = data[bit >> 6];
+	word = (word & ~mask) | (uint64_t(value) << (bit & 63));
+}
+
+void BlockStorage::resize_bits(int new_bits)
+{
+	std::vector<uint64_t> old_data = std::move(data);
+	int old_bits = bits;
+
+	data.assign(VOLUME * new_bits / 64, 0);
+	bits = new_bits;
+
+	if (old_bits == 0)
+		return;
+
+	for (size_t i = 0; i < VOLUME; ++i)
+	{
+		size_t bit = i * old_bits;
+		uint32_t value = (old_data[bit >> 6] >> (bit & 63)) & ((1u << old_bits) - 1);
+		set_palette_index(i, value);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "block.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Palette compressed block ids for one chunk.
+// Each block stores an index into a small palette of ItemIDs, bit packed
+// with a width that grows with the palette: 0 (uniform), 1, 2, 4 or 8 bits.
+// set only adds palette entries, compact drops the ones no block uses.
+struct BlockStorage
+{
+	static const size_t VOLUME = 16 * 16 * 16;
+
+	std::vector<ItemID> palette{ ItemID::Air };
+	std::vector<uint64_t> data;
+	int bits = 0;
+
+	uint32_t palette_index(size_t index) const
+	{
+		if (bits == 0)
+			return 0;
+
+		size_t bit = index * bits;
+		return (data[bit >> 6] >> (bit & 63)) & ((1u << bits) - 1);
+	}
+
+	ItemID get(size_t index) const
+	{
+		return palette[palette_index(index)];
+	}
+
+	void set(size_t index, ItemID id);
+	void fill(ItemID id);
+	// Removes unused palette entries and narrows the indices to match,
+	// down to no block data when a single id is left.
+	void compact();
+
+	size_t memory_usage() const;
+
+	// Replaces the content, indices holds one palette index per block.
+	void assign(std::vector<ItemID> new_palette, uint8_t const indices[VOLUME]);
+
+private:
+
+	void set_palette_index(size_t index, uint32_t value);
+	void resize_bits(int new_bits);
+};
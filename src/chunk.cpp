@@ -1,491 +1,746 @@
 #include "chunk.hpp"
 
-void Chunk::refresh_visible_faces()
+#include "chunk_codec.hpp"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+
+void Chunk::freeze()
 {
-	dirty = true;
+	if (is_cold())
+		return;
 
-	for (int x = 0; x < EDGE_SIZE; ++x)
+	blocks.compact();
+	ChunkCodec::encode(blocks, cold_blocks);
+	cold_blocks.shrink_to_fit();
+	blocks = BlockStorage{};
+}
+
+bool Chunk::thaw()
+{
+	if (!is_cold())
+		return true;
+
+	if (corrupt)
+		return false;
+
+	if (!ChunkCodec::decode(cold_blocks.data(), cold_blocks.size(), blocks))
 	{
-		for (int y = 0; y < EDGE_SIZE; ++y)
-		{
-			for (int z = 0; z < EDGE_SIZE; ++z)
-			{
-				if (!blocks[x][y][z].solid)
-				{
-					for (int f = 0; f < DIRECTION_MAX; ++f)
-						blocks[x][y][z].visible_faces[f] = false;
+		fprintf(stderr, "chunk: %d bytes of cold blocks failed to decode, keeping them as they are\n", (int)cold_blocks.size());
 
-					continue;
-				}
+		corrupt = true;
+		blocks = BlockStorage{};
+		refresh_solidity();
+		return false;
+	}
 
-				// TODO
-				for (int f = 0; f < DIRECTION_MAX; ++f)
-					blocks[x][y][z].visible_faces[f] = true;
-
-				if (x > 0           && blocks[x-1][y  ][z  ].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Left] = false;
-				if (x < EDGE_SIZE-1 && blocks[x+1][y  ][z  ].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Right] = false;
-				if (y > 0           && blocks[x  ][y-1][z  ].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Down] = false;
-				if (y < EDGE_SIZE-1 && blocks[x  ][y+1][z  ].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Up] = false;
-				if (z > 0           && blocks[x  ][y  ][z-1].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Back] = false;
-				if (z < EDGE_SIZE-1 && blocks[x  ][y  ][z+1].solid)
-					blocks[x][y][z].visible_faces[(int)Direction::Front] = false;
-			}
-		}
+	cold_blocks.clear();
+	cold_blocks.shrink_to_fit();
+	return true;
+}
+
+void Chunk::encode_blocks(std::vector<uint8_t> &out)
+{
+	if (is_cold())
+	{
+		out.insert(out.end(), cold_blocks.begin(), cold_blocks.end());
+		return;
 	}
+
+	blocks.compact();
+	ChunkCodec::encode(blocks, out);
 }
 
-void Chunk::hide_adjacent_chunk_faces(ivec3 delta, Chunk const &other)
+void Chunk::refresh_solidity()
 {
+	thaw();
 	dirty = true;
 
-	if (delta.x < 0)
-	{
-		for (int y = 0; y < EDGE_SIZE; ++y)
-			for (int z = 0; z < EDGE_SIZE; ++z)
-				if (blocks[0][y][z].solid && other.blocks[EDGE_LAST][y][z].solid)
-					blocks[0][y][z].visible_faces[(int)Direction::Left] = false;
-	}
-	else
-	if (delta.x > 0)
+	bool palette_solid[ITEM_ID_MAX]{};
+	bool any_solid = false;
+
+	for (size_t i = 0; i < blocks.palette.size(); ++i)
 	{
-		for (int y = 0; y < EDGE_SIZE; ++y)
-			for (int z = 0; z < EDGE_SIZE; ++z)
-				if (blocks[EDGE_LAST][y][z].solid && other.blocks[0][y][z].solid)
-					blocks[EDGE_LAST][y][z].visible_faces[(int)Direction::Right] = false;
+		palette_solid[i] = is_solid(blocks.palette[i]);
+		any_solid = any_solid || palette_solid[i];
 	}
-	else
-	if (delta.y < 0)
+
+	if (blocks.bits == 0 || !any_solid)
 	{
-		for (int x = 0; x < EDGE_SIZE; ++x)
-			for (int z = 0; z < EDGE_SIZE; ++z)
-				if (blocks[x][0][z].solid && other.blocks[x][EDGE_LAST][z].solid)
-					blocks[x][0][z].visible_faces[(int)Direction::Down] = false;
+		Row row = palette_solid[0] && blocks.bits == 0 ? Row(~0) : Row(0);
+
+		for (int a = 0; a < EDGE_SIZE; ++a)
+		{
+			for (int b = 0; b < EDGE_SIZE; ++b)
+			{
+				solid_y[a][b] = row;
+				solid_z[a][b] = row;
+			}
+		}
 	}
 	else
-	if (delta.y > 0)
 	{
+		size_t index = 0;
+
 		for (int x = 0; x < EDGE_SIZE; ++x)
+		{
 			for (int z = 0; z < EDGE_SIZE; ++z)
-				if (blocks[x][EDGE_LAST][z].solid && other.blocks[x][0][z].solid)
-					blocks[x][EDGE_LAST][z].visible_faces[(int)Direction::Up] = false;
-	}
-	else
-	if (delta.z < 0)
-	{
-		for (int x = 0; x < EDGE_SIZE; ++x)
-			for (int y = 0; y < EDGE_SIZE; ++y)
-				if (blocks[x][y][0].solid && other.blocks[x][y][EDGE_LAST].solid)
-					blocks[x][y][0].visible_faces[(int)Direction::Back] = false;
-	}
-	else
-	if (delta.z > 0)
-	{
-		for (int x = 0; x < EDGE_SIZE; ++x)
+				solid_y[x][z] = 0;
+
 			for (int y = 0; y < EDGE_SIZE; ++y)
-				if (blocks[x][y][EDGE_LAST].solid && other.blocks[x][y][0].solid)
-					blocks[x][y][EDGE_LAST].visible_faces[(int)Direction::Front] = false;
+			{
+				Row row = 0;
+
+				for (int z = 0; z < EDGE_SIZE; ++z, ++index)
+				{
+					Row solid = palette_solid[blocks.palette_index(index)];
+					row |= solid << z;
+					solid_y[x][z] |= solid << y;
+				}
+
+				solid_z[x][y] = row;
+			}
+		}
 	}
+
+	refresh_solid_bounds();
+	refresh_connectivity();
 }
 
-void Chunk::on_render(RenderParams const &params)
+void Chunk::refresh_visible_faces()
 {
-	bool gpu_cache = true;
-	if (gpu_cache)
-	{
-		if (!render_cache_gpu)
-			render_cache_gpu = params.graphics.create_cache_vertices(params.materials.find(ItemID::Dirt));
+	refresh_solidity();
 
-		if (dirty)
-		{
-			dirty = false;
-
-			FrameCacheVertices cache;
+	PaddedSolidity padded;
+	padded.set_center(*this);
+	refresh_faces(padded);
+}
 
-			params.frame.cache(cache, [&]() {
-				on_render_no_cache(params);
-			});
+void Chunk::refresh_faces(PaddedSolidity const &padded)
+{
+	// Faces of uniform solid chunks are wherever the padding layer is open.
+	if (is_uniform_solid())
+	{
+		memset(face_masks, 0, sizeof(face_masks));
 
-			render_cache_gpu->load(cache); // TODO
+		for (int b = 0; b < EDGE_SIZE; ++b)
+		{
+			face_masks[(int)Direction::Left ][0        ][b] = Row(~padded.y[0][b+1] >> 1);
+			face_masks[(int)Direction::Right][EDGE_LAST][b] = Row(~padded.y[PaddedSolidity::EDGE_LAST][b+1] >> 1);
+			face_masks[(int)Direction::Down ][0        ][b] = Row(~padded.z[b+1][0] >> 1);
+			face_masks[(int)Direction::Up   ][EDGE_LAST][b] = Row(~padded.z[b+1][PaddedSolidity::EDGE_LAST] >> 1);
+			face_masks[(int)Direction::Back ][0        ][b] = Row(~padded.y[b+1][0] >> 1);
+			face_masks[(int)Direction::Front][EDGE_LAST][b] = Row(~padded.y[b+1][PaddedSolidity::EDGE_LAST] >> 1);
 		}
 
-		params.frame.add_cached_vertices(render_cache_gpu);
+		return;
 	}
-	else
+
+	// A face is visible where a solid row meets a non-solid row in the
+	// neighbouring slice. Padded rows are a block longer on both ends, the
+	// shift drops the padding bits.
+	for (int a = 0; a < EDGE_SIZE; ++a)
 	{
-		if (dirty)
+		for (int b = 0; b < EDGE_SIZE; ++b)
 		{
-			dirty = false;
-			render_cache.clear();
+			face_masks[(int)Direction::Left ][a][b] = Row((padded.y[a+1][b+1] & ~padded.y[a  ][b+1]) >> 1);
+			face_masks[(int)Direction::Right][a][b] = Row((padded.y[a+1][b+1] & ~padded.y[a+2][b+1]) >> 1);
+			face_masks[(int)Direction::Down ][a][b] = Row((padded.z[b+1][a+1] & ~padded.z[b+1][a  ]) >> 1);
+			face_masks[(int)Direction::Up   ][a][b] = Row((padded.z[b+1][a+1] & ~padded.z[b+1][a+2]) >> 1);
+			face_masks[(int)Direction::Back ][a][b] = Row((padded.y[b+1][a+1] & ~padded.y[b+1][a  ]) >> 1);
+			face_masks[(int)Direction::Front][a][b] = Row((padded.y[b+1][a+1] & ~padded.y[b+1][a+2]) >> 1);
 		}
+	}
+}
 
-		if (render_cache.empty())
-		{
-			params.frame.cache(render_cache, [&]() {
-				on_render_no_cache(params);
-			});
-		}
+void Chunk::refresh_block_solidity(int x, int y, int z)
+{
+	Row solid = is_solid(get_block(x, y, z));
 
-		params.frame.add_cached_vertices(params.materials.find(ItemID::Dirt), render_cache); // TODO: material in cache
-	}
+	solid_y[x][z] = (solid_y[x][z] & ~Row(1 << y)) | Row(solid << y);
+	solid_z[x][y] = (solid_z[x][y] & ~Row(1 << z)) | Row(solid << z);
 }
 
-void Chunk::on_render_no_cache(RenderParams const &params)
+void Chunk::refresh_solid_bounds()
 {
-	bool greedy_meshing = true;
-	if (greedy_meshing)
+	Row any_x = 0;
+	Row any_y = 0;
+	Row any_z = 0;
+
+	for (int a = 0; a < EDGE_SIZE; ++a)
 	{
-		// Left
-		for (int x = 0; x < EDGE_SIZE; ++x)
+		Row slice_x = 0;
+
+		for (int b = 0; b < EDGE_SIZE; ++b)
 		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+			slice_x |= solid_y[a][b];
+			any_z |= solid_z[a][b];
+		}
 
-			for (int z = 0; z < EDGE_SIZE; ++z)
-			{
-				for (int y = 0; y < EDGE_SIZE; ++y)
-				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Left] || meshed[z][y])
-						continue;
+		any_x |= Row(slice_x != 0) << a;
+		any_y |= slice_x;
+	}
 
-					ItemID id = blocks[x][y][z].id;
+	if (!any_x)
+	{
+		solid_min = {};
+		solid_max = {};
+		return;
+	}
 
-					int ez = z + 1;
+	solid_min = { std::countr_zero(any_x), std::countr_zero(any_y), std::countr_zero(any_z) };
+	solid_max = { 16 - std::countl_zero(any_x), 16 - std::countl_zero(any_y), 16 - std::countl_zero(any_z) };
+}
 
-					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
-					{
-						if (!blocks[x][y][z2].visible_faces[(int)Direction::Left] || meshed[z2][y])
-							break;
+void Chunk::refresh_connectivity()
+{
+	const uint8_t all_faces = (1 << DIRECTION_MAX) - 1;
 
-						ez++;
-					}
+	if (!has_solid())
+	{
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+			face_connections[f] = all_faces;
 
-					int ey = y + 1;
+		return;
+	}
 
-					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
-					{
-						for (int z2 = z; z2 < ez; ++z2)
-							if (!blocks[x][y2][z2].visible_faces[(int)Direction::Left] || meshed[z2][y2])
-								goto _outer_left;
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+		face_connections[f] = 0;
 
-						ey++;
-					}
-					_outer_left:{}
+	// Flood fill non-solid blocks a row (bits along z) at a time. Blocks are
+	// marked visited when pushed and every push carries at least one of them,
+	// so the stack never holds more entries than there are blocks.
+	struct Item { uint8_t x, y; Row bits; };
+	Item stack[EDGE_SIZE * EDGE_SIZE * EDGE_SIZE];
+	Row visited[EDGE_SIZE][EDGE_SIZE]{};
 
-					for (int z2 = z; z2 < ez; ++z2)
-						for (int y2 = y; y2 < ey; ++y2)
-							meshed[z2][y2] = true;
+	for (int x = 0; x < EDGE_SIZE; ++x)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			while (Row unvisited = Row(~solid_z[x][y] & ~visited[x][y]))
+			{
+				uint8_t faces = 0;
+				size_t size = 0;
+				Row seed = Row(unvisited & -unvisited);
+				visited[x][y] |= seed;
+				stack[size++] = { (uint8_t)x, (uint8_t)y, seed };
 
-					{
-						ivec3 p = params.model_offset + ivec3{ x, y, z };
-						ivec3 e = params.model_offset + ivec3{ x, ey, ez };
-						vec2 s = { ez - z, ey - y };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_x(), { c.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_x(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, e.y, e.z }, -vec3::unit_x(), { s.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_x(), { c.x, c.y }, { 0.0f, 0.0f } }
-						);
-					}
+				while (size)
+				{
+					Item item = stack[--size];
+					Row open = Row(~solid_z[item.x][item.y]);
+
+					// Grow the seed bits over the open runs they belong to.
+					Row bits = item.bits;
+					for (Row grown = bits; (grown = Row((bits | bits << 1 | bits >> 1) & open)) != bits;)
+						bits = grown;
+
+					visited[item.x][item.y] |= bits;
+
+					if (item.x == 0)         faces |= 1 << (int)Direction::Left;
+					if (item.x == EDGE_LAST) faces |= 1 << (int)Direction::Right;
+					if (item.y == 0)         faces |= 1 << (int)Direction::Down;
+					if (item.y == EDGE_LAST) faces |= 1 << (int)Direction::Up;
+					if (bits & 1)                   faces |= 1 << (int)Direction::Back;
+					if (bits & (1 << EDGE_LAST))    faces |= 1 << (int)Direction::Front;
+
+					auto push = [&](int nx, int ny) {
+						if (Row next = Row(bits & ~solid_z[nx][ny] & ~visited[nx][ny]))
+						{
+							visited[nx][ny] |= next;
+							stack[size++] = { (uint8_t)nx, (uint8_t)ny, next };
+						}
+					};
+
+					if (item.x > 0)         push(item.x - 1, item.y);
+					if (item.x < EDGE_LAST) push(item.x + 1, item.y);
+					if (item.y > 0)         push(item.x, item.y - 1);
+					if (item.y < EDGE_LAST) push(item.x, item.y + 1);
 				}
+
+				for (int f = 0; f < DIRECTION_MAX; ++f)
+					if (faces & (1 << f))
+						face_connections[f] |= faces;
 			}
 		}
+	}
+}
 
-		// Right
-		for (int x = 0; x < EDGE_SIZE; ++x)
+void Chunk::reduce_to_lod(int lod)
+{
+	int const cell = 1 << lod;
+
+	Row columns[EDGE_SIZE][EDGE_SIZE];
+	lod_columns(lod, columns);
+
+	for (int cx = 0; cx < EDGE_SIZE; cx += cell)
+	{
+		for (int cz = 0; cz < EDGE_SIZE; cz += cell)
+		{
+			// The cell is filled with the top block of its first non-empty column.
+			ItemID id = ItemID::Air;
+
+			for (int x = cx; x < cx + cell && id == ItemID::Air; ++x)
+				for (int z = cz; z < cz + cell && id == ItemID::Air; ++z)
+					if (Row column = solid_y[x][z])
+						id = get_block(x, EDGE_LAST - std::countl_zero(column), z);
+
+			for (int x = cx; x < cx + cell; ++x)
+				for (int z = cz; z < cz + cell; ++z)
+					for (int y = 0; y < EDGE_SIZE; ++y)
+						set_block(x, y, z, ((columns[x][z] >> y) & 1) ? id : ItemID::Air);
+		}
+	}
+}
+
+void Chunk::lod_columns(int lod, Row (&columns)[EDGE_SIZE][EDGE_SIZE]) const
+{
+	int const cell = 1 << lod;
+	int const cell_volume = cell * cell * cell;
+
+	for (int cx = 0; cx < EDGE_SIZE; cx += cell)
+	{
+		for (int cz = 0; cz < EDGE_SIZE; cz += cell)
 		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+			// Mean top surface and lowest solid block of the columns in the cell,
+			// empty columns count as height 0.
+			int top_sum = 0;
+			int bottom = EDGE_SIZE;
 
-			for (int z = 0; z < EDGE_SIZE; ++z)
+			for (int x = cx; x < cx + cell; ++x)
 			{
-				for (int y = 0; y < EDGE_SIZE; ++y)
+				for (int z = cz; z < cz + cell; ++z)
 				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Right] || meshed[z][y])
+					Row column = solid_y[x][z];
+					if (!column)
 						continue;
 
-					ItemID id = blocks[x][y][z].id;
+					top_sum += EDGE_SIZE - std::countl_zero(column);
+					bottom = std::min(bottom, (int)std::countr_zero(column));
+				}
+			}
 
-					int ez = z + 1;
+			// Snap to whole cells, rounding the top to the nearest one.
+			int top = (top_sum + cell_volume / 2) / cell_volume * cell;
+			bottom = bottom / cell * cell;
 
-					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
-					{
-						if (!blocks[x][y][z2].visible_faces[(int)Direction::Right] || meshed[z2][y])
-							break;
+			Row column = 0;
+			for (int y = bottom; y < top; ++y)
+				column |= Row(1) << y;
 
-						ez++;
-					}
+			for (int x = cx; x < cx + cell; ++x)
+				for (int z = cz; z < cz + cell; ++z)
+					columns[x][z] = column;
+		}
+	}
+}
 
-					int ey = y + 1;
+bool Chunk::is_side_solid(Direction side) const
+{
+	const Row full = Row(~0);
+	Row all = full;
 
-					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
-					{
-						for (int z2 = z; z2 < ez; ++z2)
-							if (!blocks[x][y2][z2].visible_faces[(int)Direction::Right] || meshed[z2][y2])
-								goto _outer_right;
+	for (int a = 0; a < EDGE_SIZE; ++a)
+	{
+		switch (side)
+		{
+		case Direction::Left:  all &= solid_z[0][a]; break;
+		case Direction::Right: all &= solid_z[EDGE_LAST][a]; break;
+		case Direction::Down:  all &= solid_z[a][0]; break;
+		case Direction::Up:    all &= solid_z[a][EDGE_LAST]; break;
+		case Direction::Back:  all &= solid_y[a][0]; break;
+		case Direction::Front: all &= solid_y[a][EDGE_LAST]; break;
+		}
+	}
 
-						ey++;
-					}
-					_outer_right:{}
+	return all == full;
+}
 
-					for (int z2 = z; z2 < ez; ++z2)
-						for (int y2 = y; y2 < ey; ++y2)
-							meshed[z2][y2] = true;
+bool Chunk::is_visible(Frustum const &frustum, ivec3 chunk_pos) const
+{
+	if (!has_solid())
+		return false;
 
-					{
-						ivec3 p = params.model_offset + ivec3{ x+1, y, z };
-						ivec3 e = params.model_offset + ivec3{ x+1, ey, ez };
-						vec2 s = { ez - z, ey - y };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { e.x, p.y, p.z },  vec3::unit_x(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, p.z },  vec3::unit_x(), { s.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_x(), { c.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, p.y, e.z },  vec3::unit_x(), { c.x, s.y }, { 0.0f, 0.0f } }
-						);
-					}
-				}
-			}
-		}
+	ivec3 origin = chunk_pos * (int)EDGE_SIZE;
+	return frustum.intersects(vec3(origin + solid_min), vec3(origin + solid_max));
+}
 
-		// Down
-		for (int y = 0; y < EDGE_SIZE; ++y)
-		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+void Chunk::load_mesh(RenderParams const &params, FrameCacheVertices &vertices)
+{
+	if (gpu_cache)
+	{
+		if (!render_cache_gpu)
+			render_cache_gpu = params.graphics.create_cache_vertices(params.materials.block_material);
 
-			for (int x = 0; x < EDGE_SIZE; ++x)
-			{
+		render_cache_gpu->load(vertices); // TODO
+	}
+	else
+	{
+		render_cache = std::move(vertices);
+	}
+}
+
+void Chunk::clear_mesh()
+{
+	render_cache_gpu.reset();
+	render_cache.clear();
+	mesh_quads = 0;
+	mesh_full_quads = 0;
+}
+
+void Chunk::on_render(RenderParams const &params)
+{
+	if (gpu_cache)
+	{
+		if (render_cache_gpu)
+			params.frame.add_cached_vertices(render_cache_gpu);
+	}
+	else
+	{
+		if (!render_cache.empty())
+			params.frame.add_cached_vertices(params.materials.block_material, render_cache);
+	}
+}
+
+size_t Chunk::on_render_no_cache(MeshParams const &params, bool greedy, PaddedLight const *light)
+{
+	if (greedy)
+	{
+		std::vector<ChunkQuad> quads;
+		greedy_mesh(quads, light);
+
+		for (auto const &quad : quads)
+			add_quad(params, quad);
+
+		return quads.size();
+	}
+	else
+	{
+		size_t count = 0;
+
+		for (int x = 0; x < EDGE_SIZE; ++x)
+			for (int y = 0; y < EDGE_SIZE; ++y)
 				for (int z = 0; z < EDGE_SIZE; ++z)
 				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Down] || meshed[x][z])
+					uint8_t faces = visible_faces(x, y, z);
+					if (!faces)
 						continue;
 
-					ItemID id = blocks[x][y][z].id;
-
-					int ex = x + 1;
-
-					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
-					{
-						if (!blocks[x2][y][z].visible_faces[(int)Direction::Down] || meshed[x2][z])
-							break;
+					uint8_t face_light[DIRECTION_MAX];
+					if (light)
+						for (int f = 0; f < DIRECTION_MAX; ++f)
+							face_light[f] = light->at(ivec3{ x, y, z } + direction_offset((Direction)f));
 
-						ex++;
-					}
+					count += std::popcount(faces);
+					Cube{ get_block(x, y, z) }.on_render(params.add_offset({ x, y, z }), faces, light ? face_light : nullptr);
+				}
 
-					int ez = z + 1;
+		return count;
+	}
+}
 
-					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
-					{
-						for (int x2 = x; x2 < ex; ++x2)
-							if (!blocks[x2][y][z2].visible_faces[(int)Direction::Down] || meshed[x2][z2])
-								goto _outer_down;
+// Chunk block of bit in row of a face_masks plane.
+static ivec3 plane_block(Direction direction, int slice, int row, int bit)
+{
+	switch (direction)
+	{
+	case Direction::Left:
+	case Direction::Right: return { slice, bit, row };
+	case Direction::Down:
+	case Direction::Up:    return { row, slice, bit };
+	case Direction::Back:
+	case Direction::Front: return { row, bit, slice };
+	}
 
-						ez++;
-					}
-					_outer_down:{}
+	return {};
+}
 
-					for (int x2 = x; x2 < ex; ++x2)
-						for (int z2 = z; z2 < ez; ++z2)
-							meshed[x2][z2] = true;
+void Chunk::greedy_mesh(std::vector<ChunkQuad> &quads, PaddedLight const *light) const
+{
+	// With a single solid block type and no light every face merges with
+	// its neighbours, otherwise faces are keyed by block type and light.
+	ItemID single = ItemID::Air;
+	int solid_types = 0;
 
-					{
-						ivec3 p = params.model_offset + ivec3{ x, y, z };
-						ivec3 e = params.model_offset + ivec3{ ex, y, ez };
-						vec2 s = { ex - x, ez - z };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_y(), { c.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_y(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, p.y, e.z }, -vec3::unit_y(), { s.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, p.y, e.z }, -vec3::unit_y(), { c.x, c.y }, { 0.0f, 0.0f } }
-						);
-					}
-				}
-			}
+	for (ItemID id : blocks.palette)
+	{
+		if (is_solid(id))
+		{
+			single = id;
+			solid_types += 1;
 		}
+	}
 
-		// Up
-		for (int y = 0; y < EDGE_SIZE; ++y)
-		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+	bool keyed = light || solid_types > 1;
 
-			for (int x = 0; x < EDGE_SIZE; ++x)
-			{
-				for (int z = 0; z < EDGE_SIZE; ++z)
-				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Up] || meshed[x][z])
-						continue;
+	// Light in front of a face, walked through the flat padded volume.
+	const int PADDED = PaddedLight::EDGE_SIZE;
+	uint8_t const *padded = light ? &light->levels[0][0][0] : nullptr;
 
-					ItemID id = blocks[x][y][z].id;
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+	{
+		Direction direction = (Direction)f;
 
-					int ex = x + 1;
+		// Steps between rows and between bits of a row, see face_masks.
+		int row_step = 0;
+		int bit_step = 0;
 
-					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
-					{
-						if (!blocks[x2][y][z].visible_faces[(int)Direction::Up] || meshed[x2][z])
-							break;
+		switch (direction)
+		{
+		case Direction::Left:
+		case Direction::Right: row_step = 1;               bit_step = PADDED; break;
+		case Direction::Down:
+		case Direction::Up:    row_step = PADDED * PADDED; bit_step = 1; break;
+		case Direction::Back:
+		case Direction::Front: row_step = PADDED * PADDED; bit_step = PADDED; break;
+		}
 
-						ex++;
-					}
+		for (int slice = 0; slice < EDGE_SIZE; ++slice)
+		{
+			Row rows[EDGE_SIZE];
+			Row any = 0;
 
-					int ez = z + 1;
+			for (int i = 0; i < EDGE_SIZE; ++i)
+				any |= rows[i] = face_masks[f][slice][i];
 
-					for (int z2 = z + 1; z2 < EDGE_SIZE; ++z2)
-					{
-						for (int x2 = x; x2 < ex; ++x2)
-							if (!blocks[x2][y][z2].visible_faces[(int)Direction::Up] || meshed[x2][z2])
-								goto _outer_up;
+			if (!any)
+				continue;
 
-						ez++;
-					}
-					_outer_up:{}
+			// id | light << 8, only filled for visible faces. Slices where all
+			// faces share one key merge as if there were none.
+			uint16_t keys[EDGE_SIZE][EDGE_SIZE];
+			uint16_t slice_key = uint16_t((uint16_t)single | LIGHT_MAX << 8);
+			bool slice_keyed = false;
 
-					for (int x2 = x; x2 < ex; ++x2)
-						for (int z2 = z; z2 < ez; ++z2)
-							meshed[x2][z2] = true;
+			if (keyed)
+			{
+				// All keys are equal when they have the same bits set.
+				uint16_t any_bits = 0;
+				uint16_t all_bits = uint16_t(~0);
 
+				// Padded position of bit 0 of row 0 in front of the slice.
+				ivec3 start = plane_block(direction, slice, 0, 0) + ivec3{ 1, 1, 1 } + direction_offset(direction);
+				int start_index = (start.x * PADDED + start.y) * PADDED + start.z;
+
+				for (int i = 0; i < EDGE_SIZE; ++i)
+				{
+					for (Row r = rows[i]; r; r &= r - 1)
 					{
-						ivec3 p = params.model_offset + ivec3{ x, y+1, z };
-						ivec3 e = params.model_offset + ivec3{ ex, y+1, ez };
-						vec2 s = { ex - x, ez - z };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { p.x, e.y, p.z },  vec3::unit_y(), { c.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, e.y, e.z },  vec3::unit_y(), { c.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_y(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, p.z },  vec3::unit_y(), { s.x, c.y }, { 0.0f, 0.0f } }
-						);
+						int bit = std::countr_zero(r);
+						ItemID id = single;
+
+						if (solid_types > 1)
+						{
+							ivec3 p = plane_block(direction, slice, i, bit);
+							id = get_block(p.x, p.y, p.z);
+						}
+
+						uint8_t level = padded ? padded[start_index + i * row_step + bit * bit_step] : LIGHT_MAX;
+						keys[i][bit] = uint16_t((uint16_t)id | level << 8);
+						any_bits |= keys[i][bit];
+						all_bits &= keys[i][bit];
 					}
 				}
+
+				slice_key = all_bits;
+				slice_keyed = any_bits != all_bits;
 			}
-		}
 
-		// Back
-		for (int z = 0; z < EDGE_SIZE; ++z)
-		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+			// Faces left in row k with key.
+			auto matching = [&](int k, uint16_t key) {
+				if (!slice_keyed)
+					return rows[k];
+
+				Row result = 0;
+
+				for (Row r = rows[k]; r; r &= r - 1)
+					if (int bit = std::countr_zero(r); keys[k][bit] == key)
+						result |= Row(1u << bit);
 
-			for (int x = 0; x < EDGE_SIZE; ++x)
+				return result;
+			};
+
+			for (int i = 0; i < EDGE_SIZE; ++i)
 			{
-				for (int y = 0; y < EDGE_SIZE; ++y)
+				while (rows[i])
 				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Back] || meshed[x][y])
-						continue;
-
-					ItemID id = blocks[x][y][z].id;
+					// Grow across rows first, then along the bits shared by all of them.
+					int bit = std::countr_zero(rows[i]);
+					Row start = Row(1u << bit);
+					uint16_t key = slice_keyed ? keys[i][bit] : slice_key;
 
-					int ex = x + 1;
+					int end_i = i + 1;
+					Row shared = matching(i, key);
 
-					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
+					for (; end_i < EDGE_SIZE; ++end_i)
 					{
-						if (!blocks[x2][y][z].visible_faces[(int)Direction::Back] || meshed[x2][y])
+						Row next = matching(end_i, key);
+						if (!(next & start))
 							break;
 
-						ex++;
+						shared &= next;
 					}
 
-					int ey = y + 1;
+					int bits = std::countr_one(Row(shared >> bit));
+					Row run = Row(((1u << bits) - 1) << bit);
 
-					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
-					{
-						for (int x2 = x; x2 < ex; ++x2)
-							if (!blocks[x2][y2][z].visible_faces[(int)Direction::Back] || meshed[x2][y2])
-								goto _outer_back;
+					for (int k = i; k < end_i; ++k)
+						rows[k] &= ~run;
 
-						ey++;
-					}
-					_outer_back:{}
-
-					for (int x2 = x; x2 < ex; ++x2)
-						for (int y2 = y; y2 < ey; ++y2)
-							meshed[x2][y2] = true;
-
-					{
-						ivec3 p = params.model_offset + ivec3{ x, y, z };
-						ivec3 e = params.model_offset + ivec3{ ex, ey, z };
-						vec2 s = { ex - x, ey - y };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { p.x, p.y, p.z }, -vec3::unit_z(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, e.y, p.z }, -vec3::unit_z(), { s.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, p.z }, -vec3::unit_z(), { c.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, p.y, p.z }, -vec3::unit_z(), { c.x, s.y }, { 0.0f, 0.0f } }
-						);
-					}
+					ChunkQuad quad{};
+					quad.pos = plane_block(direction, slice, i, bit);
+					quad.direction = direction;
+					quad.id = (ItemID)(key & 0xff);
+					quad.size_u = end_i - i;
+					quad.size_v = bits;
+					quad.light = uint8_t(key >> 8);
+					quads.push_back(quad);
 				}
 			}
 		}
+	}
+}
 
-		// Front
-		for (int z = 0; z < EDGE_SIZE; ++z)
-		{
-			bool meshed[EDGE_SIZE][EDGE_SIZE]{};
+void Chunk::add_quad(MeshParams const &params, ChunkQuad const &quad)
+{
+	add_block_quad(params, quad.direction, quad.pos, quad.size_u, quad.size_v, quad.id, quad.light);
+}
 
-			for (int x = 0; x < EDGE_SIZE; ++x)
-			{
-				for (int y = 0; y < EDGE_SIZE; ++y)
-				{
-					if (!blocks[x][y][z].visible_faces[(int)Direction::Front] || meshed[x][y])
-						continue;
+void PaddedSolidity::set_center(Chunk const &chunk)
+{
+	const Row ends = Row(1) | (Row(1) << EDGE_LAST);
 
-					ItemID id = blocks[x][y][z].id;
+	for (int a = 0; a < Chunk::EDGE_SIZE; ++a)
+	{
+		for (int b = 0; b < Chunk::EDGE_SIZE; ++b)
+		{
+			y[a+1][b+1] = (y[a+1][b+1] & ends) | (Row(chunk.solid_y[a][b]) << 1);
+			z[a+1][b+1] = (z[a+1][b+1] & ends) | (Row(chunk.solid_z[a][b]) << 1);
+		}
+	}
+}
 
-					int ex = x + 1;
+void PaddedSolidity::set_border(Direction side, Chunk const &neighbour, int lod)
+{
+	using ChunkRow = Chunk::Row;
+	const int SIZE = Chunk::EDGE_SIZE;
+	const int LAST = Chunk::EDGE_LAST;
 
-					for (int x2 = x + 1; x2 < EDGE_SIZE; ++x2)
-					{
-						if (!blocks[x2][y][z].visible_faces[(int)Direction::Front] || meshed[x2][y])
-							break;
+	ChunkRow const (*solid_y)[SIZE] = neighbour.solid_y;
+	ChunkRow const (*solid_z)[SIZE] = neighbour.solid_z;
 
-						ex++;
-					}
+	// Reduced neighbours are meshed from their lod columns, rebuild both
+	// solidity sets from those. solid_z is only needed on the touching layer.
+	ChunkRow lod_y[SIZE][SIZE];
+	ChunkRow lod_z[SIZE][SIZE]{};
 
-					int ey = y + 1;
+	if (lod > 0)
+	{
+		neighbour.lod_columns(lod, lod_y);
 
-					for (int y2 = y + 1; y2 < EDGE_SIZE; ++y2)
-					{
-						for (int x2 = x; x2 < ex; ++x2)
-							if (!blocks[x2][y2][z].visible_faces[(int)Direction::Front] || meshed[x2][y2])
-								goto _outer_forward;
+		int x_min = 0, x_max = LAST;
+		int z_min = 0, z_max = LAST;
+		ChunkRow layer = ChunkRow(~0);
 
-						ey++;
-					}
-					_outer_forward:{}
+		switch (side)
+		{
+		case Direction::Left:  x_min = LAST; break;
+		case Direction::Right: x_max = 0; break;
+		case Direction::Down:  layer = ChunkRow(1 << LAST); break;
+		case Direction::Up:    layer = 1; break;
+		case Direction::Back:  z_min = LAST; break;
+		case Direction::Front: z_max = 0; break;
+		}
 
-					for (int x2 = x; x2 < ex; ++x2)
-						for (int y2 = y; y2 < ey; ++y2)
-							meshed[x2][y2] = true;
+		for (int x = x_min; x <= x_max; ++x)
+			for (int z = z_min; z <= z_max; ++z)
+				for (ChunkRow column = lod_y[x][z] & layer; column; column &= column - 1)
+					lod_z[x][std::countr_zero(column)] |= ChunkRow(1) << z;
 
-					{
-						ivec3 p = params.model_offset + ivec3{ x, y, z+1 };
-						ivec3 e = params.model_offset + ivec3{ ex, ey, z+1 };
-						vec2 s = { ex - x, ey - y };
-						vec2 c = { 0.0f, 0.0f };
-
-						params.frame.add_quad(params.materials.find(id),
-							BlockVertex{ { p.x, p.y, e.z },  vec3::unit_z(), { c.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, p.y, e.z },  vec3::unit_z(), { s.x, s.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { e.x, e.y, e.z },  vec3::unit_z(), { s.x, c.y }, { 0.0f, 0.0f } },
-							BlockVertex{ { p.x, e.y, e.z },  vec3::unit_z(), { c.x, c.y }, { 0.0f, 0.0f } }
-						);
-					}
-				}
+		solid_y = lod_y;
+		solid_z = lod_z;
+	}
+
+	// Sides across the rows copy whole rows, sides along them one bit per row.
+	for (int a = 0; a < SIZE; ++a)
+	{
+		for (int b = 0; b < SIZE; ++b)
+		{
+			switch (side)
+			{
+			case Direction::Left:
+				y[0][b+1] = Row(solid_y[LAST][b]) << 1;
+				z[0][a+1] = Row(solid_z[LAST][a]) << 1;
+				break;
+			case Direction::Right:
+				y[EDGE_LAST][b+1] = Row(solid_y[0][b]) << 1;
+				z[EDGE_LAST][a+1] = Row(solid_z[0][a]) << 1;
+				break;
+			case Direction::Down:
+				y[a+1][b+1] |= Row(solid_y[a][b] >> LAST);
+				z[a+1][0] = Row(solid_z[a][LAST]) << 1;
+				break;
+			case Direction::Up:
+				y[a+1][b+1] |= Row(solid_y[a][b] & 1) << EDGE_LAST;
+				z[a+1][EDGE_LAST] = Row(solid_z[a][0]) << 1;
+				break;
+			case Direction::Back:
+				y[a+1][0] = Row(solid_y[a][LAST]) << 1;
+				z[a+1][b+1] |= Row(solid_z[a][b] >> LAST);
+				break;
+			case Direction::Front:
+				y[a+1][EDGE_LAST] = Row(solid_y[a][0]) << 1;
+				z[a+1][b+1] |= Row(solid_z[a][b] & 1) << EDGE_LAST;
+				break;
 			}
 		}
 	}
-	else
+}
+
+PaddedLight::PaddedLight()
+{
+	memset(levels, LIGHT_MAX, sizeof(levels));
+}
+
+void PaddedLight::set_center(Chunk const &chunk)
+{
+	if (chunk.light.levels.empty())
 	{
-		for (int x = 0; x < EDGE_SIZE; ++x)
-			for (int y = 0; y < EDGE_SIZE; ++y)
-				for (int z = 0; z < EDGE_SIZE; ++z)
-					blocks[x][y][z].on_render(params.add_offset({ x, y, z }));
+		uint8_t level = chunk.light.combined(0);
+
+		for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+			for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+				memset(&levels[x+1][y+1][1], level, Chunk::EDGE_SIZE);
+
+		return;
+	}
+
+	for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+		for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+			for (int z = 0; z < Chunk::EDGE_SIZE; ++z)
+				levels[x+1][y+1][z+1] = chunk.light.combined(Chunk::block_index(x, y, z));
+}
+
+void PaddedLight::set_border(Direction side, Chunk const &neighbour)
+{
+	const int LAST = Chunk::EDGE_LAST;
+	LightStorage const &light = neighbour.light;
+
+	for (int a = 0; a < Chunk::EDGE_SIZE; ++a)
+	{
+		for (int b = 0; b < Chunk::EDGE_SIZE; ++b)
+		{
+			switch (side)
+			{
+			case Direction::Left:  levels[0][a+1][b+1]         = light.combined(Chunk::block_index(LAST, a, b)); break;
+			case Direction::Right: levels[EDGE_LAST][a+1][b+1] = light.combined(Chunk::block_index(0, a, b)); break;
+			case Direction::Down:  levels[a+1][0][b+1]         = light.combined(Chunk::block_index(a, LAST, b)); break;
+			case Direction::Up:    levels[a+1][EDGE_LAST][b+1] = light.combined(Chunk::block_index(a, 0, b)); break;
+			case Direction::Back:  levels[a+1][b+1][0]         = light.combined(Chunk::block_index(a, b, LAST)); break;
+			case Direction::Front: levels[a+1][b+1][EDGE_LAST] = light.combined(Chunk::block_index(a, b, 0)); break;
+			}
+		}
 	}
 }
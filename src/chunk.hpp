@@ -3,20 +3,229 @@
 #include "gfxengine/graphics.hpp"
 
 #include "block.hpp"
+#include "block_storage.hpp"
+#include "frustum.hpp"
+#include "light.hpp"
 #include <vector>
 
+// Greedy mesher output, in chunk local block coordinates.
+// size_u spans the rows of a face plane and size_v the bits of a row:
+// Left/Right  u = z, v = y
+// Down/Up     u = x, v = z
+// Back/Front  u = x, v = y
+struct ChunkQuad
+{
+	ivec3 pos;
+	Direction direction;
+	ItemID id;
+	uint8_t size_u;
+	uint8_t size_v;
+	uint8_t light; // of the blocks in front of the quad, see PaddedLight
+};
+
+struct PaddedSolidity;
+struct PaddedLight;
+
 struct Chunk
 {
 	static const size_t EDGE_SIZE = 16;
 	static const size_t EDGE_LAST = EDGE_SIZE - 1;
-	Cube blocks[EDGE_SIZE][EDGE_SIZE][EDGE_SIZE]{};
+	static const int LOD_MAX = 3; // coarsest level, 1 << LOD_MAX blocks per cell
+	BlockStorage blocks;
+	// ChunkCodec encoded blocks while the chunk is cold, blocks is empty then.
+	std::vector<uint8_t> cold_blocks;
+	LightStorage light; // see WorldLight, kept while the chunk is cold
+	uint64_t used_frame = 0; // last frame the chunk was drawn, see World::on_render
+
+	// One bit per block, EDGE_SIZE bits per row.
+	using Row = uint16_t;
+
+	// Solidity columns, rebuilt from blocks by refresh_solidity.
+	// solid_y[x][z] bit y, solid_z[x][y] bit z.
+	Row solid_y[EDGE_SIZE][EDGE_SIZE]{};
+	Row solid_z[EDGE_SIZE][EDGE_SIZE]{};
+
+	// Visible faces, one plane of rows per slice along the face normal.
+	// Only built for meshing, see refresh_faces.
+	// Left/Right  [x][z] bit y
+	// Down/Up     [y][x] bit z
+	// Back/Front  [z][x] bit y
+	Row face_masks[DIRECTION_MAX][EDGE_SIZE][EDGE_SIZE]{};
+
+	// Bit j of face_connections[i] is set when faces i and j (Direction) are
+	// connected through non-solid blocks inside this chunk.
+	uint8_t face_connections[DIRECTION_MAX]{};
+	uint64_t reached_frame = 0; // see World::find_reachable_chunks
+
+	// Chunk local bounds of solid blocks, max exclusive. Empty when min == max.
+	ivec3 solid_min{};
+	ivec3 solid_max{};
 
 	bool dirty = false;
+	bool modified = false; // edited since it was generated, loaded or saved, see World::unloaded_edits
+	bool corrupt = false;  // cold_blocks failed to decode, see thaw
+	uint64_t mesh_version = 0; // version of the last submitted mesh job, see World::on_render
+	// Level of detail of the last submitted mesh, see reduce_to_lod.
+	int lod = 0;
+	size_t mesh_quads = 0;      // quads in the loaded mesh
+	size_t mesh_full_quads = 0; // quads of the last lod 0 mesh, kept while meshed coarser
+	bool gpu_cache = true;
 	FrameCacheVertices render_cache;
 	std::shared_ptr<GraphicsCacheVertices> render_cache_gpu;
 
+	static size_t block_index(int x, int y, int z)
+	{
+		return ((size_t)x * EDGE_SIZE + y) * EDGE_SIZE + z;
+	}
+
+	ItemID get_block(int x, int y, int z) const
+	{
+		return blocks.get(block_index(x, y, z));
+	}
+
+	// Does not refresh solidity, call refresh_solidity after a batch of edits,
+	// or refresh_block_solidity for single blocks (see World::set_block).
+	void set_block(int x, int y, int z, ItemID id)
+	{
+		blocks.set(block_index(x, y, z), id);
+	}
+
+	bool is_solid_at(int x, int y, int z) const
+	{
+		return (solid_y[x][z] >> y) & 1;
+	}
+
+	bool is_cold() const
+	{
+		return !cold_blocks.empty();
+	}
+
+	// Compresses blocks into cold_blocks, face masks and meshes are kept.
+	void freeze();
+	// Restores blocks, needed before reading or editing them. Returns false
+	// when cold_blocks do not decode: the chunk is marked corrupt and keeps
+	// them, so it reads as air but saves its original data, see World::set_block.
+	bool thaw();
+	// Appends the blocks as ChunkCodec data, cold chunks copy cold_blocks.
+	void encode_blocks(std::vector<uint8_t> &out);
+
+	bool has_solid() const
+	{
+		return solid_max.x > solid_min.x;
+	}
+
+	// A single solid block type, stored without block data (see BlockStorage).
+	// Only its border layers can have visible faces.
+	bool is_uniform_solid() const
+	{
+		return !is_cold() && blocks.bits == 0 && is_solid(blocks.palette[0]);
+	}
+
+	// Every block of the layer touching side is solid, from solidity.
+	bool is_side_solid(Direction side) const;
+
+	size_t memory_usage() const
+	{
+		return sizeof(*this) - sizeof(blocks) + blocks.memory_usage() + cold_blocks.capacity() + light.memory_usage();
+	}
+
+	bool is_face_visible(int x, int y, int z, Direction direction) const
+	{
+		switch (direction)
+		{
+		case Direction::Left:
+		case Direction::Right: return (face_masks[(int)direction][x][z] >> y) & 1;
+		case Direction::Down:
+		case Direction::Up:    return (face_masks[(int)direction][y][x] >> z) & 1;
+		case Direction::Back:
+		case Direction::Front: return (face_masks[(int)direction][z][x] >> y) & 1;
+		}
+
+		return false;
+	}
+
+	uint8_t visible_faces(int x, int y, int z) const
+	{
+		uint8_t result = 0;
+
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+			result |= (uint8_t)is_face_visible(x, y, z, (Direction)f) << f;
+
+		return result;
+	}
+
+	// Rebuilds solidity, bounds and connectivity from blocks and marks the chunk dirty.
+	void refresh_solidity();
+	// refresh_solidity, then faces as if the chunk had no neighbours.
 	void refresh_visible_faces();
-	void hide_adjacent_chunk_faces(ivec3 delta, Chunk const &other);
+	// Builds face_masks in one pass from the chunk's solidity padded with its
+	// neighbours' border layers, so faces between chunks come out hidden.
+	void refresh_faces(PaddedSolidity const &padded);
+	// Updates solid_y and solid_z for one block after set_block.
+	void refresh_block_solidity(int x, int y, int z);
+	void refresh_solid_bounds();
+	void refresh_connectivity();
+	// Replaces blocks by a heightfield of (1 << lod)^3 cells built from the top
+	// surface of each column. Needs refreshed solidity, refresh again afterwards.
+	void reduce_to_lod(int lod);
+	// solid_y as reduce_to_lod(lod) would leave it, without touching blocks.
+	void lod_columns(int lod, Row (&columns)[EDGE_SIZE][EDGE_SIZE]) const;
+
+	bool is_visible(Frustum const &frustum, ivec3 chunk_pos) const;
+	void load_mesh(RenderParams const &params, FrameCacheVertices &vertices);
+	// Releases the loaded mesh, for chunks without visible faces.
+	void clear_mesh();
 	void on_render(RenderParams const &params);
-	void on_render_no_cache(RenderParams const &params);
+	// Returns the number of quads emitted. greedy false emits one quad per
+	// visible block face. Without light faces are fully lit.
+	size_t on_render_no_cache(MeshParams const &params, bool greedy = true, PaddedLight const *light = nullptr);
+	// Merges faces of the same block type and light level.
+	void greedy_mesh(std::vector<ChunkQuad> &quads, PaddedLight const *light = nullptr) const;
+
+	static void add_quad(MeshParams const &params, ChunkQuad const &quad);
+};
+
+// Solidity of a chunk and the one block layer around it, EDGE_SIZE^3 blocks
+// with index 0 and EDGE_LAST taken from the six neighbours. Edges and corners
+// are unused, faces only look at the blocks they touch.
+// Snapshotted on the render thread so meshing never reads other chunks.
+struct PaddedSolidity
+{
+	static const size_t EDGE_SIZE = Chunk::EDGE_SIZE + 2;
+	static const size_t EDGE_LAST = EDGE_SIZE - 1;
+
+	using Row = uint32_t; // EDGE_SIZE bits
+
+	// Chunk block (x, y, z) is at index and bit + 1.
+	Row y[EDGE_SIZE][EDGE_SIZE]{}; // [x][z] bit y
+	Row z[EDGE_SIZE][EDGE_SIZE]{}; // [x][y] bit z
+
+	// Overwrites the inner rows, keeping the bits set_border put on their ends.
+	void set_center(Chunk const &chunk);
+	// Copies the layer of neighbour touching the chunk on side, as
+	// Chunk::reduce_to_lod(lod) would leave it when lod > 0.
+	void set_border(Direction side, Chunk const &neighbour, int lod = 0);
+};
+
+// Combined light levels (see LightStorage::combined) of a chunk and the one
+// block layer around it, taken from the six neighbours. The layer is
+// LIGHT_MAX where there is no neighbour. Snapshotted with PaddedSolidity.
+struct PaddedLight
+{
+	static const size_t EDGE_SIZE = Chunk::EDGE_SIZE + 2;
+	static const size_t EDGE_LAST = EDGE_SIZE - 1;
+
+	uint8_t levels[EDGE_SIZE][EDGE_SIZE][EDGE_SIZE]; // chunk block (x, y, z) at [x+1][y+1][z+1]
+
+	PaddedLight();
+
+	// Light of the block at chunk local pos, one block outside the chunk at most.
+	uint8_t at(ivec3 pos) const
+	{
+		return levels[pos.x + 1][pos.y + 1][pos.z + 1];
+	}
+
+	void set_center(Chunk const &chunk);
+	// Copies the layer of neighbour touching the chunk on side.
+	void set_border(Direction side, Chunk const &neighbour);
 };
@@ -0,0 +1,365 @@
+#include "chunk_codec.hpp"
+
+#include "chunk.hpp"
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+
+enum class CodecMode : uint8_t
+{
+	Uniform,
+	Packed,
+	Columns,
+};
+
+// Runs of one column along y, ends are exclusive and the last one is EDGE_SIZE.
+struct ColumnRuns
+{
+	int count = 0;
+	uint8_t values[Chunk::EDGE_SIZE];
+	uint8_t ends[Chunk::EDGE_SIZE];
+};
+
+// Bits are written least significant first.
+struct BitWriter
+{
+	std::vector<uint8_t> &out;
+	uint64_t acc = 0;
+	int acc_bits = 0;
+
+	void put(uint32_t value, int bits)
+	{
+		acc |= uint64_t(value) << acc_bits;
+		acc_bits += bits;
+
+		while (acc_bits >= 8)
+		{
+			out.push_back((uint8_t)acc);
+			acc >>= 8;
+			acc_bits -= 8;
+		}
+	}
+
+	void flush()
+	{
+		if (acc_bits > 0)
+			out.push_back((uint8_t)acc);
+
+		acc = 0;
+		acc_bits = 0;
+	}
+};
+
+struct BitReader
+{
+	uint8_t const *src;
+	uint8_t const *end;
+	uint64_t acc = 0;
+	int acc_bits = 0;
+
+	// bits <= 32. Bits past the end of the data read as 0, skip reports them.
+	uint32_t peek(int bits)
+	{
+		if (acc_bits < bits)
+		{
+			if (end - src >= 8)
+			{
+				uint64_t next;
+				memcpy(&next, src, sizeof(next));
+				acc |= next << acc_bits;
+				src += (63 - acc_bits) >> 3;
+				acc_bits |= 56;
+			}
+			else
+			{
+				while (acc_bits < bits && src != end)
+				{
+					acc |= uint64_t(*src++) << acc_bits;
+					acc_bits += 8;
+				}
+			}
+		}
+
+		return uint32_t(acc & ((1ull << bits) - 1));
+	}
+
+	// Returns false when skipping past the end of the data.
+	bool skip(int bits)
+	{
+		acc >>= bits;
+		acc_bits -= bits;
+		return acc_bits >= 0;
+	}
+
+	bool get(int bits, uint32_t &value)
+	{
+		value = peek(bits);
+		return skip(bits);
+	}
+};
+
+// Columns are visited along z for each x, reversing z every other x so that
+// consecutive columns are always neighbours.
+int column_z(int x, int step)
+{
+	return (x & 1) ? Chunk::EDGE_LAST - step : step;
+}
+
+bool predictable(ColumnRuns const &prev, ColumnRuns const &cur)
+{
+	if (prev.count != cur.count)
+		return false;
+
+	for (int i = 0; i < cur.count; ++i)
+		if (prev.values[i] != cur.values[i])
+			return false;
+
+	for (int i = 0; i < cur.count - 1; ++i)
+		if (cur.ends[i] + 1 < prev.ends[i] || cur.ends[i] > prev.ends[i] + 1)
+			return false;
+
+	return true;
+}
+
+void write_header(std::vector<uint8_t> &out, CodecMode mode, std::vector<ItemID> const &palette)
+{
+	out.push_back((uint8_t)mode);
+	out.push_back(uint8_t(palette.size()));
+	out.push_back(uint8_t(palette.size() >> 8));
+
+	for (auto id : palette)
+		out.push_back((uint8_t)id);
+}
+
+} // namespace
+
+void ChunkCodec::encode(BlockStorage const &blocks, std::vector<uint8_t> &out)
+{
+	size_t start = out.size();
+
+	if (blocks.bits == 0)
+	{
+		write_header(out, CodecMode::Uniform, { blocks.palette[0] });
+		return;
+	}
+
+	write_header(out, CodecMode::Columns, blocks.palette);
+
+	int value_bits = std::bit_width(blocks.palette.size() - 1);
+	size_t packed_size = out.size() - start + 1 + blocks.data.size() * sizeof(uint64_t);
+
+	BitWriter writer{ out };
+	ColumnRuns prev;
+
+	for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+	{
+		for (int step = 0; step < Chunk::EDGE_SIZE; ++step)
+		{
+			int z = column_z(x, step);
+
+			ColumnRuns cur;
+			for (int y = 0; y < Chunk::EDGE_SIZE; ++y)
+			{
+				uint8_t value = (uint8_t)blocks.palette_index(Chunk::block_index(x, y, z));
+
+				if (cur.count == 0 || cur.values[cur.count - 1] != value)
+					cur.values[cur.count++] = value;
+
+				cur.ends[cur.count - 1] = uint8_t(y + 1);
+			}
+
+			if (predictable(prev, cur))
+			{
+				writer.put(1, 1);
+
+				for (int i = 0; i < cur.count - 1; ++i)
+				{
+					if (cur.ends[i] == prev.ends[i])
+						writer.put(0, 1);
+					else
+						writer.put(cur.ends[i] > prev.ends[i] ? 0b11 : 0b01, 2);
+				}
+			}
+			else
+			{
+				writer.put(0, 1);
+				writer.put(cur.count - 1, 4);
+
+				for (int i = 0; i < cur.count; ++i)
+					writer.put(cur.values[i], value_bits);
+
+				for (int i = 0; i < cur.count - 1; ++i)
+					writer.put(cur.ends[i] - 1, 4);
+			}
+
+			prev = cur;
+		}
+	}
+
+	writer.flush();
+
+	// Noisy chunks do not have long runs, store them as they are in memory.
+	if (out.size() - start > packed_size)
+	{
+		out.resize(start);
+		write_header(out, CodecMode::Packed, blocks.palette);
+		out.push_back(uint8_t(blocks.bits));
+
+		size_t offset = out.size();
+		out.resize(offset + blocks.data.size() * sizeof(uint64_t));
+		memcpy(out.data() + offset, blocks.data.data(), blocks.data.size() * sizeof(uint64_t));
+	}
+}
+
+bool ChunkCodec::decode(uint8_t const *data, size_t size, BlockStorage &blocks)
+{
+	if (size < 3)
+		return false;
+
+	CodecMode mode = (CodecMode)data[0];
+	size_t palette_size = data[1] | (size_t(data[2]) << 8);
+	if (palette_size == 0 || palette_size > ITEM_ID_MAX || size < 3 + palette_size)
+		return false;
+
+	std::vector<ItemID> palette((ItemID const *)(data + 3), (ItemID const *)(data + 3 + palette_size));
+	uint8_t const *src = data + 3 + palette_size;
+	uint8_t const *end = data + size;
+
+	// Palette indices in block index order.
+	uint8_t indices[BlockStorage::VOLUME];
+
+	switch (mode)
+	{
+	case CodecMode::Uniform:
+	{
+		if (palette_size != 1 || src != end)
+			return false;
+
+		blocks.fill(palette[0]);
+		return true;
+	}
+	case CodecMode::Packed:
+	{
+		if (src == end)
+			return false;
+
+		int bits = *src++;
+		if (bits != 1 && bits != 2 && bits != 4 && bits != 8)
+			return false;
+
+		if (palette_size > (1ull << bits) || size_t(end - src) != BlockStorage::VOLUME * bits / 64 * sizeof(uint64_t))
+			return false;
+
+		for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+		{
+			size_t bit = i * bits;
+			indices[i] = (src[bit >> 3] >> (bit & 7)) & ((1u << bits) - 1);
+
+			if (indices[i] >= palette_size)
+				return false;
+		}
+
+		break;
+	}
+	case CodecMode::Columns:
+	{
+		int value_bits = std::bit_width(palette_size - 1);
+
+		BitReader reader{ src, end };
+		ColumnRuns prev;
+
+		for (int x = 0; x < Chunk::EDGE_SIZE; ++x)
+		{
+			for (int step = 0; step < Chunk::EDGE_SIZE; ++step)
+			{
+				int z = column_z(x, step);
+
+				uint32_t predicted;
+				if (!reader.get(1, predicted))
+					return false;
+
+				ColumnRuns cur;
+
+				if (predicted)
+				{
+					if (prev.count == 0)
+						return false;
+
+					cur = prev;
+
+					// Branchless, run ends move too randomly to predict:
+					// 0 keeps the end, 01 moves it down and 11 up.
+					for (int i = 0; i < cur.count - 1; ++i)
+					{
+						uint32_t code = reader.peek(2);
+						uint32_t changed = code & 1;
+						int delta = int(code >> 1) * 2 - 1;
+
+						if (!reader.skip(1 + changed))
+							return false;
+
+						cur.ends[i] = uint8_t(cur.ends[i] + int(changed) * delta);
+					}
+				}
+				else
+				{
+					uint32_t count;
+					if (!reader.get(4, count))
+						return false;
+
+					cur.count = (int)count + 1;
+
+					for (int i = 0; i < cur.count; ++i)
+					{
+						uint32_t value = 0;
+						if (!reader.get(value_bits, value) || value >= palette_size)
+							return false;
+
+						cur.values[i] = (uint8_t)value;
+					}
+
+					for (int i = 0; i < cur.count - 1; ++i)
+					{
+						uint32_t end_y;
+						if (!reader.get(4, end_y))
+							return false;
+
+						cur.ends[i] = uint8_t(end_y + 1);
+					}
+
+					cur.ends[cur.count - 1] = Chunk::EDGE_SIZE;
+				}
+
+				// Each run fills up to the top, later runs overwrite the rest.
+				uint8_t column[Chunk::EDGE_SIZE * 2];
+				int y = 0;
+
+				for (int i = 0; i < cur.count; ++i)
+				{
+					if (cur.ends[i] <= y || cur.ends[i] > Chunk::EDGE_SIZE)
+						return false;
+
+					memset(column + y, cur.values[i], Chunk::EDGE_SIZE);
+					y = cur.ends[i];
+				}
+
+				for (y = 0; y < Chunk::EDGE_SIZE; ++y)
+					indices[Chunk::block_index(x, y, z)] = column[y];
+
+				prev = cur;
+			}
+
+		}
+
+		break;
+	}
+	default:
+		return false;
+	}
+
+	blocks.assign(std::move(palette), indices);
+	return true;
+}
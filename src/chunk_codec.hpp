@@ -0,0 +1,22 @@
+#pragma once
+
+#include "block_storage.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Compact encoding of chunk blocks, used for region files and cold chunks.
+// Layout: uint8 mode, uint16 palette size, palette ids, then by mode
+//   Uniform  nothing, the palette holds the only id
+//   Columns  bit stream of runs along y for each column, see below
+//   Packed   uint8 bits, BlockStorage::data as is (chunks without long runs)
+// Columns are visited along z for each x, reversing z every other x. A column
+// whose runs match the previous one with each run end moved by at most one is
+// coded as 1 bit plus 1-2 bits per run end, others store run count, palette
+// indices and run ends explicitly. Terrain surface columns mostly take 3-5 bits.
+struct ChunkCodec
+{
+	static void encode(BlockStorage const &blocks, std::vector<uint8_t> &out);
+	// Returns false and leaves blocks unchanged when data is malformed.
+	static bool decode(uint8_t const *data, size_t size, BlockStorage &blocks);
+};
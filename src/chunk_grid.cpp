@@ -0,0 +1,102 @@
+#include "chunk_grid.hpp"
+
+#include <stdexcept>
+
+ChunkGrid::ChunkGrid()
+	: slots(size_t(WINDOW_XZ) * WINDOW_Y * WINDOW_XZ)
+{
+}
+
+std::unique_ptr<Chunk> &ChunkGrid::at(ivec3 pos)
+{
+	int32_t index = find_index(pos);
+	if (index < 0)
+		throw std::out_of_range("ChunkGrid::at");
+
+	return items[index].second;
+}
+
+std::unique_ptr<Chunk> const &ChunkGrid::at(ivec3 pos) const
+{
+	int32_t index = find_index(pos);
+	if (index < 0)
+		throw std::out_of_range("ChunkGrid::at");
+
+	return items[index].second;
+}
+
+std::pair<ChunkGrid::iterator, bool> ChunkGrid::emplace(ivec3 pos, std::unique_ptr<Chunk> chunk)
+{
+	if (int32_t index = find_index(pos); index >= 0)
+		return { items.begin() + index, false };
+
+	int32_t index = (int32_t)items.size();
+	items.emplace_back(pos, std::move(chunk));
+
+	Slot &slot = slots[slot_index(pos)];
+
+	if (slot.index < 0)
+		slot = { pos, index };
+	else
+		overflow.emplace(pos, index);
+
+	return { items.begin() + index, true };
+}
+
+ChunkGrid::iterator ChunkGrid::erase(iterator it)
+{
+	int32_t index = int32_t(it - items.begin());
+	ivec3 pos = it->first;
+	size_t slot_i = slot_index(pos);
+	Slot &slot = slots[slot_i];
+
+	if (slot.index >= 0 && slot.pos == pos)
+	{
+		slot.index = -1;
+
+		// Hand the slot to a chunk that was waiting for it.
+		for (auto waiting = overflow.begin(); waiting != overflow.end(); ++waiting)
+		{
+			if (slot_index(waiting->first) == slot_i)
+			{
+				slot = { waiting->first, waiting->second };
+				overflow.erase(waiting);
+				break;
+			}
+		}
+	}
+	else
+	{
+		overflow.erase(pos);
+	}
+
+	int32_t last = int32_t(items.size()) - 1;
+
+	if (index != last)
+	{
+		items[index] = std::move(items[last]);
+		set_index(items[index].first, index);
+	}
+
+	items.pop_back();
+	return items.begin() + index;
+}
+
+void ChunkGrid::clear()
+{
+	items.clear();
+	overflow.clear();
+
+	for (auto &slot : slots)
+		slot.index = -1;
+}
+
+void ChunkGrid::set_index(ivec3 pos, int32_t index)
+{
+	Slot &slot = slots[slot_index(pos)];
+
+	if (slot.index >= 0 && slot.pos == pos)
+		slot.index = index;
+	else
+		overflow[pos] = index;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Chunks by position, with the interface of the unordered_map it replaces.
+// Lookups go through a toroidal window of WINDOW_XZ x WINDOW_Y x WINDOW_XZ
+// slots indexed by position modulo the window size, so the chunks around the
+// camera resolve without hashing and the window follows whatever is loaded.
+// A chunk whose slot is held by another position goes to a sparse map until
+// the slot frees up.
+// Chunks are kept in one dense array for iteration. erase moves the last
+// chunk into the gap, so it returns the position to continue iterating from.
+struct ChunkGrid
+{
+	using value_type = std::pair<ivec3, std::unique_ptr<Chunk>>;
+	using iterator = std::vector<value_type>::iterator;
+	using const_iterator = std::vector<value_type>::const_iterator;
+
+	static const int WINDOW_XZ = 64;
+	static const int WINDOW_Y = 16;
+
+	ChunkGrid();
+
+	iterator begin() { return items.begin(); }
+	iterator end() { return items.end(); }
+	const_iterator begin() const { return items.begin(); }
+	const_iterator end() const { return items.end(); }
+
+	size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+	// Chunks outside the window, looked up through the sparse map.
+	size_t overflow_size() const { return overflow.size(); }
+
+	iterator find(ivec3 pos)
+	{
+		int32_t index = find_index(pos);
+		return index < 0 ? items.end() : items.begin() + index;
+	}
+
+	const_iterator find(ivec3 pos) const
+	{
+		int32_t index = find_index(pos);
+		return index < 0 ? items.end() : items.begin() + index;
+	}
+
+	bool contains(ivec3 pos) const
+	{
+		return find_index(pos) >= 0;
+	}
+
+	std::unique_ptr<Chunk> &at(ivec3 pos);
+	std::unique_ptr<Chunk> const &at(ivec3 pos) const;
+
+	std::pair<iterator, bool> emplace(ivec3 pos, std::unique_ptr<Chunk> chunk);
+	iterator erase(iterator it);
+	void clear();
+
+private:
+
+	struct Slot
+	{
+		ivec3 pos;
+		int32_t index = -1;
+	};
+
+	static size_t slot_index(ivec3 pos)
+	{
+		// Power of two sizes, & wraps negative coordinates too.
+		return ((size_t(pos.x & (WINDOW_XZ - 1)) * WINDOW_Y + size_t(pos.y & (WINDOW_Y - 1))) * WINDOW_XZ) + size_t(pos.z & (WINDOW_XZ - 1));
+	}
+
+	int32_t find_index(ivec3 pos) const
+	{
+		Slot const &slot = slots[slot_index(pos)];
+
+		if (slot.index >= 0 && slot.pos == pos)
+			return slot.index;
+
+		if (overflow.empty())
+			return -1;
+
+		auto it = overflow.find(pos);
+		return it == overflow.end() ? -1 : it->second;
+	}
+
+	void set_index(ivec3 pos, int32_t index);
+
+	std::vector<value_type> items;
+	std::vector<Slot> slots;
+	std::unordered_map<ivec3, int32_t> overflow;
+};
+
+// Last chunk looked up in a ChunkGrid, for walks that mostly stay inside
+// one chunk. The grid is only read, chunks are handed out as stored.
+struct ChunkCache
+{
+	ChunkGrid const &chunks;
+	ivec3 pos{};
+	Chunk *chunk = nullptr;
+	bool found = false;
+
+	// Null for unloaded chunks.
+	Chunk *get(ivec3 chunk_pos)
+	{
+		if (!found || chunk_pos != pos)
+		{
+			auto it = chunks.find(chunk_pos);
+			chunk = it != chunks.end() ? it->second.get() : nullptr;
+			pos = chunk_pos;
+			found = true;
+		}
+
+		return chunk;
+	}
+};
@@ -0,0 +1,123 @@
+#include "chunk_mesher.hpp"
+
+#include "profiler.hpp"
+
+ChunkMesher::ChunkMesher(size_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		size_t hardware = std::thread::hardware_concurrency();
+		thread_count = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (size_t i = 0; i < thread_count; ++i)
+		threads.emplace_back([this]() { worker_main(); });
+}
+
+ChunkMesher::~ChunkMesher()
+{
+	{
+		std::lock_guard lock(jobs_mutex);
+		stopping = true;
+	}
+
+	jobs_cv.notify_all();
+
+	for (auto &thread : threads)
+		thread.join();
+}
+
+void ChunkMesher::submit(std::unique_ptr<ChunkMeshJob> job)
+{
+	{
+		std::lock_guard lock(jobs_mutex);
+		jobs.push_back(std::move(job));
+	}
+
+	jobs_cv.notify_one();
+}
+
+void ChunkMesher::collect(std::vector<std::unique_ptr<ChunkMeshJob>> &result)
+{
+	std::lock_guard lock(completed_mutex);
+
+	if (result.empty())
+	{
+		result.swap(completed);
+	}
+	else
+	{
+		for (auto &job : completed)
+			result.push_back(std::move(job));
+
+		completed.clear();
+	}
+}
+
+void ChunkMesher::run(ChunkMeshJob &job, Frame &frame)
+{
+	auto chunk = std::make_unique<Chunk>();
+	chunk->blocks = std::move(job.blocks);
+
+	{
+		ProfileScope scope(ProfileStage::Faces);
+
+		// The padded borders already hold reduced neighbours at the same lod,
+		// only the center is replaced. Borders towards other lods stay open
+		// and keep their faces as skirts over the cracks between the surfaces.
+		if (job.lod > 0)
+		{
+			chunk->refresh_solidity();
+			chunk->reduce_to_lod(job.lod);
+			chunk->refresh_solidity();
+			job.solidity.set_center(*chunk);
+		}
+
+		chunk->refresh_faces(job.solidity);
+	}
+
+	ProfileScope scope(ProfileStage::Mesh);
+
+	MeshParams params{
+		.frame = frame,
+		.materials = *job.materials,
+		.chunk_pos = job.chunk_pos,
+		.model_offset = ivec3{},
+	};
+
+	frame.reset();
+	job.vertices.clear();
+	frame.cache(job.vertices, [&]() {
+		// Reduced surfaces move into blocks that hold no light, they are meshed fully lit.
+		job.quads = chunk->on_render_no_cache(params, true, job.lod == 0 ? &job.light : nullptr);
+	});
+
+	if (job.lod == 0)
+		job.full_quads = job.quads;
+}
+
+void ChunkMesher::worker_main()
+{
+	Frame frame;
+
+	while (true)
+	{
+		std::unique_ptr<ChunkMeshJob> job;
+
+		{
+			std::unique_lock lock(jobs_mutex);
+			jobs_cv.wait(lock, [this]() { return stopping || !jobs.empty(); });
+
+			if (stopping)
+				return;
+
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		run(*job, frame);
+
+		std::lock_guard lock(completed_mutex);
+		completed.push_back(std::move(job));
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "chunk.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Snapshot of a chunk and the solid and light layers around it, meshed off the render thread.
+struct ChunkMeshJob
+{
+	ivec3 chunk_pos;
+	uint64_t version = 0;
+	BlockStorage blocks;
+	PaddedSolidity solidity; // borders without a neighbour at the same lod are left open
+	PaddedLight light;       // baked into lod 0 meshes, coarser ones are fully lit
+	int lod = 0; // see Chunk::reduce_to_lod
+	MaterialManager const *materials = nullptr;
+
+	// results
+	FrameCacheVertices vertices;
+	size_t quads = 0;
+	size_t full_quads = 0; // quads at lod 0, reduced jobs pass on the chunk's last lod 0 count
+};
+
+// Worker pool running face culling and greedy meshing for ChunkMeshJobs.
+// Finished jobs are handed back in batches through collect.
+struct ChunkMesher
+{
+	// thread_count 0 uses all hardware threads but one.
+	explicit ChunkMesher(size_t thread_count = 0);
+	~ChunkMesher();
+
+	void submit(std::unique_ptr<ChunkMeshJob> job);
+	void collect(std::vector<std::unique_ptr<ChunkMeshJob>> &result);
+
+	static void run(ChunkMeshJob &job, Frame &frame);
+
+private:
+
+	void worker_main();
+
+	std::mutex jobs_mutex;
+	std::condition_variable jobs_cv;
+	std::deque<std::unique_ptr<ChunkMeshJob>> jobs;
+	bool stopping = false;
+
+	std::mutex completed_mutex;
+	std::vector<std::unique_ptr<ChunkMeshJob>> completed;
+
+	std::vector<std::thread> threads;
+};
@@ -0,0 +1,199 @@
+#include "collision.hpp"
+
+#include "world.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace
+{
+
+// Null for unloaded chunks and chunks without solid blocks.
+Chunk const *solid_chunk(ChunkCache &cache, ivec3 chunk_pos)
+{
+	Chunk const *chunk = cache.get(chunk_pos);
+	return chunk && chunk->has_solid() ? chunk : nullptr;
+}
+
+// std::floor and std::ceil are library calls without SSE4.1 and took most
+// of the time of a move.
+int floor_int(float value)
+{
+	int i = (int)value;
+	return i - (value < float(i));
+}
+
+int ceil_int(float value)
+{
+	int i = (int)value;
+	return i + (value > float(i));
+}
+
+Chunk::Row row_mask(int from, int to)
+{
+	return Chunk::Row(((1u << (to - from + 1)) - 1) << from);
+}
+
+// Any solid block at world x, z with world y in [y0, y1].
+bool any_solid_y(ChunkCache &cache, int x, int z, int y0, int y1)
+{
+	for (int y = y0; y <= y1;)
+	{
+		int last = std::min(y1, y | (int)Chunk::EDGE_LAST);
+
+		if (Chunk const *chunk = solid_chunk(cache, World::chunk_of({ x, y, z })))
+			if (chunk->solid_y[x & Chunk::EDGE_LAST][z & Chunk::EDGE_LAST] & row_mask(y & Chunk::EDGE_LAST, last & Chunk::EDGE_LAST))
+				return true;
+
+		y = last + 1;
+	}
+
+	return false;
+}
+
+// Nearest block along axis y or z from first to last (either order) that
+// is solid in any row of the box's range on the other two axes. The range
+// is walked a chunk at a time, a masked row covers the part of each column
+// inside the chunk. Returns false when there is none.
+bool first_solid_along_rows(ChunkCache &cache, int axis, int first, int last, int const from[3], int const to[3], int &cell)
+{
+	int step = last >= first ? 1 : -1;
+	// Columns run along axis, p and q are the other two axes.
+	int p_axis = 0;
+	int q_axis = axis == 1 ? 2 : 1;
+
+	for (int begin = first; (last - begin) * step >= 0;)
+	{
+		// Part of the range inside the chunk layer of begin.
+		int layer_end = step > 0 ? std::min(last, begin | (int)Chunk::EDGE_LAST) : std::max(last, begin & ~(int)Chunk::EDGE_LAST);
+		int lo = std::min(begin, layer_end);
+		Chunk::Row mask = row_mask(lo & Chunk::EDGE_LAST, std::max(begin, layer_end) & Chunk::EDGE_LAST);
+		Chunk::Row hits = 0;
+
+		for (int p = from[p_axis]; p <= to[p_axis]; ++p)
+		{
+			for (int q = from[q_axis]; q <= to[q_axis]; ++q)
+			{
+				ivec3 pos = axis == 1 ? ivec3{ p, lo, q } : ivec3{ p, q, lo };
+
+				if (Chunk const *chunk = solid_chunk(cache, World::chunk_of(pos)))
+				{
+					int x = p & Chunk::EDGE_LAST;
+					int other = q & Chunk::EDGE_LAST;
+					hits |= (axis == 1 ? chunk->solid_y[x][other] : chunk->solid_z[x][other]) & mask;
+				}
+			}
+		}
+
+		if (hits)
+		{
+			int base = lo & ~(int)Chunk::EDGE_LAST;
+			cell = step > 0 ? base + std::countr_zero(hits) : base + (int)Chunk::EDGE_LAST - std::countl_zero(hits);
+			return true;
+		}
+
+		begin = layer_end + step;
+	}
+
+	return false;
+}
+
+// Nearest layer of blocks along x from first to last (either order) with a
+// solid block in the box's y and z ranges. Returns false when there is none.
+bool first_solid_slab_x(ChunkCache &cache, int first, int last, int const from[3], int const to[3], int &cell)
+{
+	int step = last >= first ? 1 : -1;
+
+	for (int x = first; (last - x) * step >= 0; x += step)
+	{
+		for (int z = from[2]; z <= to[2]; ++z)
+		{
+			if (any_solid_y(cache, x, z, from[1], to[1]))
+			{
+				cell = x;
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Part of delta along axis the box can move before touching a solid block.
+// from and to are the blocks the box covers.
+float sweep(ChunkCache &cache, float const lo[3], float const hi[3], int const from[3], int const to[3], int axis, float delta)
+{
+	if (delta == 0.0f)
+		return 0.0f;
+
+	// Blocks the leading face passes through, nearest first.
+	int first = delta > 0.0f ? floor_int(hi[axis]) : ceil_int(lo[axis]) - 1;
+	int last = delta > 0.0f ? ceil_int(hi[axis] + delta) - 1 : floor_int(lo[axis] + delta);
+	int cell;
+
+	bool hit = axis == 0
+		? first_solid_slab_x(cache, first, last, from, to, cell)
+		: first_solid_along_rows(cache, axis, first, last, from, to, cell);
+
+	if (!hit)
+		return delta;
+
+	if (delta > 0.0f)
+		return std::clamp(float(cell) - hi[axis] - Collision::SKIN, 0.0f, delta);
+	else
+		return std::clamp(float(cell + 1) - lo[axis] + Collision::SKIN, delta, 0.0f);
+}
+
+} // namespace
+
+CollisionMove Collision::move(World const &world, Aabb const &box, vec3 delta)
+{
+	ChunkCache cache{ world.chunks };
+
+	float lo[3]{ box.min.x, box.min.y, box.min.z };
+	float hi[3]{ box.max.x, box.max.y, box.max.z };
+	float wanted[3]{ delta.x, delta.y, delta.z };
+	float applied[3]{};
+
+	// Blocks the box covers, touching a block is not covering it.
+	int from[3];
+	int to[3];
+
+	for (int a = 0; a < 3; ++a)
+	{
+		from[a] = floor_int(lo[a]);
+		to[a] = ceil_int(hi[a]) - 1;
+	}
+
+	CollisionMove result;
+
+	for (int axis : { 1, 0, 2 })
+	{
+		applied[axis] = sweep(cache, lo, hi, from, to, axis, wanted[axis]);
+		lo[axis] += applied[axis];
+		hi[axis] += applied[axis];
+		from[axis] = floor_int(lo[axis]);
+		to[axis] = ceil_int(hi[axis]) - 1;
+
+		if (applied[axis] != wanted[axis])
+			result.blocked |= 1 << (axis * 2 + (wanted[axis] > 0.0f ? 1 : 0));
+	}
+
+	result.delta = { applied[0], applied[1], applied[2] };
+	return result;
+}
+
+bool Collision::overlaps(World const &world, Aabb const &box)
+{
+	ChunkCache cache{ world.chunks };
+
+	int y0 = floor_int(box.min.y);
+	int y1 = ceil_int(box.max.y) - 1;
+
+	for (int x = floor_int(box.min.x); x < box.max.x; ++x)
+		for (int z = floor_int(box.min.z); z < box.max.z; ++z)
+			if (any_solid_y(cache, x, z, y0, y1))
+				return true;
+
+	return false;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "block.hpp"
+
+struct World;
+
+// Axis aligned box in world coordinates, one unit per block.
+struct Aabb
+{
+	vec3 min;
+	vec3 max;
+};
+
+struct CollisionMove
+{
+	vec3 delta{};        // part of the requested delta that was applied
+	uint8_t blocked = 0; // bit per Direction the box was stopped moving towards
+};
+
+// Boxes moving against the solid blocks of a World. Moves are swept one
+// axis at a time, each slab of blocks ahead of the box tested with a few
+// masked solidity rows, and stop at the first slab holding a solid block.
+// Blocks in unloaded chunks are not solid, as in World::is_solid_block.
+struct Collision
+{
+	// Gap kept between a stopped box and the block that stopped it, so the
+	// box never overlaps the block after rounding.
+	static constexpr float SKIN = 1.0f / 1024.0f;
+
+	// Moves box by delta along y first, then x and z, so boxes resting on
+	// the ground still slide. box should not overlap solid blocks already.
+	static CollisionMove move(World const &world, Aabb const &box, vec3 delta);
+	static bool overlaps(World const &world, Aabb const &box);
+};
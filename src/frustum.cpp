@@ -0,0 +1,46 @@
+#include "frustum.hpp"
+
+Frustum Frustum::from_matrix(mat4 const &mvp)
+{
+	// Columns of mvp, read back through the matrix-vector product so this
+	// does not depend on the matrix storage order.
+	vec4 c0 = mvp * vec4{ 1.0f, 0.0f, 0.0f, 0.0f };
+	vec4 c1 = mvp * vec4{ 0.0f, 1.0f, 0.0f, 0.0f };
+	vec4 c2 = mvp * vec4{ 0.0f, 0.0f, 1.0f, 0.0f };
+	vec4 c3 = mvp * vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+
+	vec4 rows[4]{
+		{ c0.x, c1.x, c2.x, c3.x },
+		{ c0.y, c1.y, c2.y, c3.y },
+		{ c0.z, c1.z, c2.z, c3.z },
+		{ c0.w, c1.w, c2.w, c3.w },
+	};
+
+	Frustum result;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		vec4 const &w = rows[3];
+		vec4 const &r = rows[i];
+		result.planes[i * 2 + 0] = { w.x + r.x, w.y + r.y, w.z + r.z, w.w + r.w };
+		result.planes[i * 2 + 1] = { w.x - r.x, w.y - r.y, w.z - r.z, w.w - r.w };
+	}
+
+	return result;
+}
+
+bool Frustum::intersects(vec3 box_min, vec3 box_max) const
+{
+	for (auto const &plane : planes)
+	{
+		// Corner of the box farthest along the plane normal.
+		float x = plane.x >= 0.0f ? box_max.x : box_min.x;
+		float y = plane.y >= 0.0f ? box_max.y : box_min.y;
+		float z = plane.z >= 0.0f ? box_max.z : box_min.z;
+
+		if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f)
+			return false;
+	}
+
+	return true;
+}
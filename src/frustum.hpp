@@ -0,0 +1,15 @@
+#pragma once
+
+#include "gfxengine/frame.hpp"
+
+// View frustum as six planes (a, b, c, d), a point p is inside a plane when
+// a*p.x + b*p.y + c*p.z + d >= 0. Planes are extracted from a clip matrix
+// with OpenGL depth range (-w..w).
+struct Frustum
+{
+	vec4 planes[6];
+
+	static Frustum from_matrix(mat4 const &mvp);
+
+	bool intersects(vec3 box_min, vec3 box_max) const;
+};
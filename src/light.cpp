@@ -0,0 +1,560 @@
+#include "light.hpp"
+
+#include "world.hpp"
+
+#include <bit>
+#include <cstring>
+
+void LightStorage::set(size_t index, LightChannel channel, uint8_t level)
+{
+	uint8_t value = get(index);
+	value = channel == LightChannel::Sky ? uint8_t((value & 0x0f) | level << 4) : uint8_t((value & 0xf0) | level);
+
+	if (levels.empty())
+	{
+		if (value == fill)
+			return;
+
+		levels.assign(BlockStorage::VOLUME, fill);
+	}
+
+	levels[index] = value;
+}
+
+void LightStorage::assign(uint8_t const values[BlockStorage::VOLUME])
+{
+	bool uniform = true;
+
+	for (size_t i = 1; i < BlockStorage::VOLUME && uniform; ++i)
+		uniform = values[i] == values[0];
+
+	if (uniform)
+	{
+		levels.clear();
+		levels.shrink_to_fit();
+		fill = values[0];
+	}
+	else
+	{
+		levels.assign(values, values + BlockStorage::VOLUME);
+	}
+}
+
+namespace
+{
+
+const int EDGE_SIZE = Chunk::EDGE_SIZE;
+const int EDGE_LAST = Chunk::EDGE_LAST;
+
+const LightChannel CHANNELS[]{ LightChannel::Sky, LightChannel::Block };
+
+ivec3 local_of(ivec3 pos)
+{
+	return { pos.x & EDGE_LAST, pos.y & EDGE_LAST, pos.z & EDGE_LAST };
+}
+
+size_t index_of(ivec3 local)
+{
+	return Chunk::block_index(local.x, local.y, local.z);
+}
+
+bool is_inside(ivec3 local)
+{
+	return local.x >= 0 && local.x < EDGE_SIZE && local.y >= 0 && local.y < EDGE_SIZE && local.z >= 0 && local.z < EDGE_SIZE;
+}
+
+bool is_solid_local(Chunk const &chunk, ivec3 local)
+{
+	return chunk.is_solid_at(local.x, local.y, local.z);
+}
+
+// Level a block lit with level passes on to its neighbour towards direction.
+uint8_t spread_level(uint8_t level, LightChannel channel, Direction direction)
+{
+	if (channel == LightChannel::Sky && direction == Direction::Down && level == LIGHT_MAX)
+		return LIGHT_MAX;
+
+	return level > 0 ? level - 1 : 0;
+}
+
+struct Propagation
+{
+	WorldLight &light;
+	ChunkCache cache;
+
+	ivec3 last_changed{};
+	bool any_changed = false;
+
+	// Neighbour of the block at pos (local in chunk) towards direction.
+	// Null when its chunk is not loaded.
+	Chunk *neighbour(Chunk *chunk, ivec3 pos, ivec3 local, Direction direction, ivec3 &n_pos, ivec3 &n_local)
+	{
+		ivec3 offset = direction_offset(direction);
+		n_pos = pos + offset;
+		n_local = local + offset;
+
+		if (is_inside(n_local))
+			return chunk;
+
+		n_local = local_of(n_pos);
+		return cache.get(World::chunk_of(n_pos));
+	}
+
+	void mark_changed(ivec3 pos, ivec3 local)
+	{
+		ivec3 chunk_pos = World::chunk_of(pos);
+
+		if (!any_changed || chunk_pos != last_changed)
+		{
+			light.changed_chunks.insert(chunk_pos);
+			last_changed = chunk_pos;
+			any_changed = true;
+		}
+
+		// Faces of the neighbour touching a border block are lit by it.
+		if (local.x == 0)         light.changed_chunks.insert(chunk_pos + ivec3{ -1, 0, 0 });
+		if (local.x == EDGE_LAST) light.changed_chunks.insert(chunk_pos + ivec3{ 1, 0, 0 });
+		if (local.y == 0)         light.changed_chunks.insert(chunk_pos + ivec3{ 0, -1, 0 });
+		if (local.y == EDGE_LAST) light.changed_chunks.insert(chunk_pos + ivec3{ 0, 1, 0 });
+		if (local.z == 0)         light.changed_chunks.insert(chunk_pos + ivec3{ 0, 0, -1 });
+		if (local.z == EDGE_LAST) light.changed_chunks.insert(chunk_pos + ivec3{ 0, 0, 1 });
+	}
+
+	void set_level(Chunk &chunk, ivec3 pos, ivec3 local, LightChannel channel, uint8_t level)
+	{
+		chunk.light.set(index_of(local), channel, level);
+		mark_changed(pos, local);
+	}
+
+	// Clears the light node.level gave its neighbours. Neighbours lit by
+	// something else are queued to spread their light back.
+	void remove(WorldLight::Node node)
+	{
+		ivec3 local = local_of(node.pos);
+		Chunk *chunk = cache.get(World::chunk_of(node.pos));
+
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+		{
+			Direction direction = (Direction)f;
+			ivec3 n_pos, n_local;
+			Chunk *n_chunk = neighbour(chunk, node.pos, local, direction, n_pos, n_local);
+			if (!n_chunk)
+				continue;
+
+			uint8_t level = n_chunk->light.get(index_of(n_local), node.channel);
+			if (level == 0)
+				continue;
+
+			// Emitters keep their own light.
+			if (is_solid_local(*n_chunk, n_local))
+			{
+				light.add_queue.push_back({ n_pos, level, node.channel });
+				continue;
+			}
+
+			bool falls = spread_level(node.level, node.channel, direction) == node.level;
+
+			if (level < node.level || (falls && level == node.level))
+			{
+				set_level(*n_chunk, n_pos, n_local, node.channel, 0);
+				light.remove_queue.push_back({ n_pos, level, node.channel });
+			}
+			else
+			{
+				light.add_queue.push_back({ n_pos, level, node.channel });
+			}
+		}
+	}
+
+	// Spreads the current light of the node's block to its neighbours.
+	void add(WorldLight::Node node)
+	{
+		ivec3 local = local_of(node.pos);
+		Chunk *chunk = cache.get(World::chunk_of(node.pos));
+		if (!chunk)
+			return;
+
+		uint8_t level = chunk->light.get(index_of(local), node.channel);
+		if (level <= 1)
+			return;
+
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+		{
+			Direction direction = (Direction)f;
+			ivec3 n_pos, n_local;
+			Chunk *n_chunk = neighbour(chunk, node.pos, local, direction, n_pos, n_local);
+			if (!n_chunk || is_solid_local(*n_chunk, n_local))
+				continue;
+
+			uint8_t spread = spread_level(level, node.channel, direction);
+
+			if (n_chunk->light.get(index_of(n_local), node.channel) < spread)
+			{
+				set_level(*n_chunk, n_pos, n_local, node.channel, spread);
+				light.add_queue.push_back({ n_pos, spread, node.channel });
+			}
+		}
+	}
+};
+
+// Sky falling straight down from above the chunk, block light from its
+// emitters. Queues the blocks that can light their neighbours inside the
+// chunk, the chunk above must be lit already.
+void light_chunk(WorldLight &light, World &world, ivec3 pos, Chunk &chunk)
+{
+	chunk.thaw();
+
+	bool emitters = false;
+	for (ItemID id : chunk.blocks.palette)
+		emitters = emitters || light_emission(id) > 0;
+
+	// Buried rock neither holds nor passes light.
+	if (chunk.is_uniform_solid() && !emitters)
+	{
+		chunk.light = LightStorage{};
+		return;
+	}
+
+	Chunk const *above = nullptr;
+	if (auto it = world.chunks.find(pos + ivec3{ 0, 1, 0 }); it != world.chunks.end())
+		above = it->second.get();
+
+	// Open air under open sky. From blocks rather than has_solid, solid
+	// bounds lag behind edits until the chunk is meshed.
+	bool open = chunk.blocks.bits == 0 && !is_solid(chunk.blocks.palette[0]);
+
+	if (open && !emitters && (!above || (above->light.levels.empty() && above->light.fill >> 4 == LIGHT_MAX)))
+	{
+		chunk.light = LightStorage{};
+		chunk.light.fill = LIGHT_MAX << 4;
+		return;
+	}
+
+	uint8_t values[BlockStorage::VOLUME];
+	Chunk::Row sky_rows[EDGE_SIZE][EDGE_SIZE]{}; // [x][y] bit z, blocks with full sky light
+
+	for (int x = 0; x < EDGE_SIZE; ++x)
+	{
+		for (int z = 0; z < EDGE_SIZE; ++z)
+		{
+			// Blocks above the highest solid one, none when the sky is covered.
+			Chunk::Row column = chunk.solid_y[x][z];
+			Chunk::Row sky = 0;
+
+			if (!above || above->light.get(Chunk::block_index(x, 0, z), LightChannel::Sky) == LIGHT_MAX)
+				sky = column ? Chunk::Row(~0u << (EDGE_SIZE - std::countl_zero(column))) : Chunk::Row(~0);
+
+			for (int y = 0; y < EDGE_SIZE; ++y)
+			{
+				Chunk::Row lit = (sky >> y) & 1;
+				values[Chunk::block_index(x, y, z)] = uint8_t(lit * (LIGHT_MAX << 4));
+				sky_rows[x][y] |= Chunk::Row(lit << z);
+			}
+		}
+	}
+
+	ivec3 origin = pos * EDGE_SIZE;
+
+	if (emitters)
+	{
+		for (size_t i = 0; i < BlockStorage::VOLUME; ++i)
+		{
+			if (uint8_t emission = light_emission(chunk.blocks.get(i)))
+			{
+				values[i] |= emission;
+				ivec3 local{ int(i / (EDGE_SIZE * EDGE_SIZE)), int(i / EDGE_SIZE % EDGE_SIZE), int(i % EDGE_SIZE) };
+				light.add_queue.push_back({ origin + local, emission, LightChannel::Block });
+			}
+		}
+	}
+
+	chunk.light.assign(values);
+
+	// Full sky only spreads sideways, into open blocks under an overhang.
+	Chunk::Row dark[EDGE_SIZE][EDGE_SIZE];
+
+	for (int x = 0; x < EDGE_SIZE; ++x)
+		for (int y = 0; y < EDGE_SIZE; ++y)
+			dark[x][y] = Chunk::Row(~chunk.solid_z[x][y] & ~sky_rows[x][y]);
+
+	for (int x = 0; x < EDGE_SIZE; ++x)
+	{
+		for (int y = 0; y < EDGE_SIZE; ++y)
+		{
+			Chunk::Row around = Chunk::Row(dark[x][y] << 1 | dark[x][y] >> 1);
+			if (x > 0)         around |= dark[x - 1][y];
+			if (x < EDGE_LAST) around |= dark[x + 1][y];
+
+			for (Chunk::Row seeds = sky_rows[x][y] & around; seeds; seeds &= seeds - 1)
+				light.add_queue.push_back({ origin + ivec3{ x, y, std::countr_zero(seeds) }, LIGHT_MAX, LightChannel::Sky });
+		}
+	}
+}
+
+// Light of the block layer of a chunk touching side, [u][v] over the two
+// other axes in x, y, z order.
+void read_layer(LightStorage const &light, Direction side, uint8_t layer[EDGE_SIZE][EDGE_SIZE])
+{
+	if (light.levels.empty())
+	{
+		memset(layer, light.fill, EDGE_SIZE * EDGE_SIZE);
+		return;
+	}
+
+	int at = (int)side & 1 ? EDGE_LAST : 0;
+	uint8_t const *levels = light.levels.data();
+
+	for (int u = 0; u < EDGE_SIZE; ++u)
+	{
+		switch ((int)side / 2)
+		{
+		case 0: memcpy(layer[u], levels + Chunk::block_index(at, u, 0), EDGE_SIZE); break;
+		case 1: memcpy(layer[u], levels + Chunk::block_index(u, at, 0), EDGE_SIZE); break;
+		case 2:
+			for (int v = 0; v < EDGE_SIZE; ++v)
+				layer[u][v] = levels[Chunk::block_index(u, v, at)];
+			break;
+		}
+	}
+}
+
+// Queues the blocks on either side of the border between a freshly lit
+// chunk and its neighbour towards side that can light the other one.
+void exchange_border(Propagation &propagation, ivec3 pos, Chunk &chunk, Direction side, Chunk &neighbour, bool neighbour_fresh)
+{
+	WorldLight &light = propagation.light;
+	int axis = (int)side / 2;
+	int u_axis = axis == 0 ? 1 : 0;
+	int v_axis = axis == 2 ? 1 : 2;
+	bool positive = (int)side & 1;
+
+	ivec3 origin = pos * EDGE_SIZE;
+	ivec3 n_origin = origin + direction_offset(side) * EDGE_SIZE;
+
+	// Buried rock neither gives nor takes light, but a new chunk of it can
+	// still cover the sky of the chunk below.
+	auto dark_rock = [](Chunk const &c) {
+		return c.is_uniform_solid() && c.light.levels.empty() && c.light.fill == 0;
+	};
+
+	if (dark_rock(neighbour) || (dark_rock(chunk) && (side != Direction::Down || neighbour_fresh)))
+		return;
+
+	// Both sides evenly lit, nothing crosses when nothing would cross
+	// between open blocks.
+	if (chunk.light.levels.empty() && neighbour.light.levels.empty())
+	{
+		bool crosses = false;
+
+		for (LightChannel channel : CHANNELS)
+		{
+			uint8_t level = chunk.light.get(0, channel);
+			uint8_t n_level = neighbour.light.get(0, channel);
+
+			crosses = crosses ||
+				(channel == LightChannel::Sky && side == Direction::Down && !neighbour_fresh && n_level == LIGHT_MAX && level != LIGHT_MAX) ||
+				(!neighbour.is_uniform_solid() && spread_level(level, channel, side) > n_level) ||
+				(!chunk.is_uniform_solid() && spread_level(n_level, channel, opposite(side)) > level);
+		}
+
+		if (!crosses)
+			return;
+	}
+
+	uint8_t layer[EDGE_SIZE][EDGE_SIZE];
+	uint8_t n_layer[EDGE_SIZE][EDGE_SIZE];
+	read_layer(chunk.light, side, layer);
+	read_layer(neighbour.light, opposite(side), n_layer);
+
+	// Light never spreads to a block as bright on both channels.
+	if (memcmp(layer, n_layer, sizeof(layer)) == 0)
+		return;
+
+	for (int u = 0; u < EDGE_SIZE; ++u)
+	{
+		for (int v = 0; v < EDGE_SIZE; ++v)
+		{
+			if (layer[u][v] == n_layer[u][v])
+				continue;
+
+			int a[3];
+			a[axis] = positive ? EDGE_LAST : 0;
+			a[u_axis] = u;
+			a[v_axis] = v;
+
+			int b[3]{ a[0], a[1], a[2] };
+			b[axis] = EDGE_LAST - a[axis];
+
+			ivec3 local{ a[0], a[1], a[2] };
+			ivec3 n_local{ b[0], b[1], b[2] };
+			size_t index = index_of(local);
+			size_t n_index = index_of(n_local);
+			bool solid = is_solid_local(chunk, local);
+			bool n_solid = is_solid_local(neighbour, n_local);
+
+			for (LightChannel channel : CHANNELS)
+			{
+				uint8_t level = chunk.light.get(index, channel);
+				uint8_t n_level = neighbour.light.get(n_index, channel);
+
+				// The chunk below lit its top from the open sky this chunk now covers.
+				if (channel == LightChannel::Sky && side == Direction::Down && !neighbour_fresh &&
+					n_level == LIGHT_MAX && level != LIGHT_MAX)
+				{
+					propagation.set_level(neighbour, n_origin + n_local, n_local, channel, 0);
+					light.remove_queue.push_back({ n_origin + n_local, n_level, channel });
+					continue;
+				}
+
+				if (!n_solid && spread_level(level, channel, side) > n_level)
+					light.add_queue.push_back({ origin + local, level, channel });
+
+				if (!solid && spread_level(n_level, channel, opposite(side)) > level)
+					light.add_queue.push_back({ n_origin + n_local, n_level, channel });
+			}
+		}
+	}
+}
+
+} // namespace
+
+void WorldLight::light_chunks(World &world, std::span<ivec3 const> positions)
+{
+	if (positions.empty())
+		return;
+
+	// Top down, so sky light falls into each chunk from the one above.
+	std::vector<ivec3> order(positions.begin(), positions.end());
+	std::sort(order.begin(), order.end(), [](ivec3 a, ivec3 b) { return a.y > b.y; });
+
+	std::unordered_set<ivec3> fresh(positions.begin(), positions.end());
+
+	for (ivec3 pos : order)
+		if (auto it = world.chunks.find(pos); it != world.chunks.end())
+			light_chunk(*this, world, pos, *it->second);
+
+	Propagation propagation{ *this, { world.chunks } };
+
+	for (ivec3 pos : order)
+	{
+		auto it = world.chunks.find(pos);
+		if (it == world.chunks.end())
+			continue;
+
+		Chunk &chunk = *it->second;
+
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+		{
+			ivec3 n_pos = pos + direction_offset((Direction)f);
+
+			if (auto n_it = world.chunks.find(n_pos); n_it != world.chunks.end())
+				exchange_border(propagation, pos, chunk, (Direction)f, *n_it->second, fresh.contains(n_pos));
+		}
+	}
+
+	update(world);
+}
+
+void WorldLight::relight(World &world)
+{
+	remove_queue.clear();
+	add_queue.clear();
+
+	std::vector<ivec3> positions;
+	for (auto const &chunk : world.chunks)
+		positions.push_back(chunk.first);
+
+	light_chunks(world, positions);
+}
+
+void WorldLight::block_changed(World &world, ivec3 pos, ItemID old_id, ItemID new_id)
+{
+	Propagation propagation{ *this, { world.chunks } };
+	Chunk *chunk = propagation.cache.get(World::chunk_of(pos));
+	if (!chunk)
+		return;
+
+	ivec3 local = local_of(pos);
+	size_t index = index_of(local);
+
+	if (is_solid(new_id))
+	{
+		for (LightChannel channel : CHANNELS)
+		{
+			if (uint8_t level = chunk->light.get(index, channel))
+			{
+				propagation.set_level(*chunk, pos, local, channel, 0);
+				remove_queue.push_back({ pos, level, channel });
+			}
+		}
+	}
+	else
+	{
+		if (uint8_t level = chunk->light.get(index, LightChannel::Block); level > 0 && light_emission(old_id) > 0)
+		{
+			propagation.set_level(*chunk, pos, local, LightChannel::Block, 0);
+			remove_queue.push_back({ pos, level, LightChannel::Block });
+		}
+
+		// Newly open, light flows back in from around it.
+		if (is_solid(old_id))
+		{
+			for (int f = 0; f < DIRECTION_MAX; ++f)
+			{
+				ivec3 n_pos, n_local;
+				Chunk *n_chunk = propagation.neighbour(chunk, pos, local, (Direction)f, n_pos, n_local);
+
+				if (!n_chunk)
+				{
+					if ((Direction)f == Direction::Up)
+					{
+						propagation.set_level(*chunk, pos, local, LightChannel::Sky, LIGHT_MAX);
+						add_queue.push_back({ pos, LIGHT_MAX, LightChannel::Sky });
+					}
+
+					continue;
+				}
+
+				for (LightChannel channel : CHANNELS)
+					if (uint8_t level = n_chunk->light.get(index_of(n_local), channel))
+						add_queue.push_back({ n_pos, level, channel });
+			}
+		}
+	}
+
+	if (uint8_t emission = light_emission(new_id))
+	{
+		propagation.set_level(*chunk, pos, local, LightChannel::Block, emission);
+		add_queue.push_back({ pos, emission, LightChannel::Block });
+	}
+}
+
+size_t WorldLight::update(World &world, size_t max_steps)
+{
+	Propagation propagation{ *this, { world.chunks } };
+	size_t steps = 0;
+
+	auto more = [&]() { return max_steps == 0 || steps < max_steps; };
+
+	while (!remove_queue.empty() && more())
+	{
+		Node node = remove_queue.front();
+		remove_queue.pop_front();
+		propagation.remove(node);
+		steps += 1;
+	}
+
+	// Spreading before every removal is done would bring back light that
+	// is about to be cleared.
+	while (remove_queue.empty() && !add_queue.empty() && more())
+	{
+		Node node = add_queue.front();
+		add_queue.pop_front();
+		propagation.add(node);
+		steps += 1;
+	}
+
+	stats.steps = steps;
+	stats.pending = remove_queue.size() + add_queue.size();
+	return steps;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "block_storage.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+struct World;
+
+enum class LightChannel : uint8_t
+{
+	Sky,
+	Block,
+};
+
+// Sky and block light of one chunk, 4 bits each with sky in the high nibble.
+// Chunks lit evenly throughout, open air or buried rock, only store fill.
+// levels is allocated by the first set that differs from it.
+struct LightStorage
+{
+	std::vector<uint8_t> levels; // BlockStorage::VOLUME entries indexed like Chunk::block_index, or empty
+	uint8_t fill = 0;
+
+	uint8_t get(size_t index) const
+	{
+		return levels.empty() ? fill : levels[index];
+	}
+
+	uint8_t get(size_t index, LightChannel channel) const
+	{
+		uint8_t value = get(index);
+		return channel == LightChannel::Sky ? value >> 4 : value & 0xf;
+	}
+
+	// Level a face in front of the block is lit with.
+	uint8_t combined(size_t index) const
+	{
+		uint8_t value = get(index);
+		return std::max<uint8_t>(value >> 4, value & 0xf);
+	}
+
+	void set(size_t index, LightChannel channel, uint8_t level);
+	// Replaces the content, keeping only fill when all values are the same.
+	void assign(uint8_t const values[BlockStorage::VOLUME]);
+
+	size_t memory_usage() const
+	{
+		return levels.capacity();
+	}
+};
+
+struct WorldLightStats
+{
+	size_t steps = 0;        // queue entries processed by the last update
+	size_t pending = 0;      // queue entries left after it
+	size_t relit_chunks = 0; // chunks remeshed for their light by the last update
+};
+
+// Flood filled light over the loaded chunks of a World. Sky light enters
+// the top of columns without a loaded chunk above and falls through
+// non-solid blocks without loss, block light spreads from emitting blocks
+// (see light_emission). Every other step costs a level. Solid blocks stop
+// light and hold none unless they emit it.
+// Edits only queue work. update spreads it with the usual two queues:
+// removals clear the light an old source gave, collecting the surviving
+// light at the edge of the cleared region, which is then spread again, so
+// only blocks whose level changes are visited.
+struct WorldLight
+{
+	struct Node
+	{
+		ivec3 pos;     // world block position
+		uint8_t level; // before removal, unused by additions
+		LightChannel channel;
+	};
+
+	std::deque<Node> remove_queue;
+	std::deque<Node> add_queue;
+
+	// Chunks whose light changed, with the neighbours of changed border
+	// blocks, not remeshed yet. Kept until the queues run empty.
+	std::unordered_set<ivec3> changed_chunks;
+	WorldLightStats stats;
+
+	bool idle() const
+	{
+		return remove_queue.empty() && add_queue.empty();
+	}
+
+	// Lights chunks that were just loaded, exchanging light with the loaded
+	// chunks around them. Runs the queues to the end.
+	void light_chunks(World &world, std::span<ivec3 const> positions);
+	// Drops all queued work and lights every loaded chunk from scratch.
+	void relight(World &world);
+	// Queues the light changes of a block edit, after its solidity was
+	// refreshed. The chunk of pos must be loaded.
+	void block_changed(World &world, ivec3 pos, ItemID old_id, ItemID new_id);
+	// Processes up to max_steps queue entries, removals first. 0 runs until
+	// the queues are empty. Returns the number of entries processed.
+	size_t update(World &world, size_t max_steps = 0);
+};
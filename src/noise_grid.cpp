@@ -0,0 +1,19 @@
+#include "noise_grid.hpp"
+
+#include "gfxengine/noise_generator.hpp"
+
+void NoiseGrid::fill(NoiseGenerator const &gen, int origin_x, int origin_z, double scale)
+{
+	double xs[SIZE];
+	double zs[SIZE];
+
+	for (int i = 0; i < SIZE; ++i)
+	{
+		xs[i] = (origin_x + i) / scale;
+		zs[i] = (origin_z + i) / scale;
+	}
+
+	for (int x = 0; x < SIZE; ++x)
+		for (int z = 0; z < SIZE; ++z)
+			values[x][z] = gen.noise(xs[x], zs[z]);
+}
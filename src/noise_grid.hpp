@@ -0,0 +1,20 @@
+#pragma once
+
+#include "chunk.hpp"
+
+class NoiseGenerator;
+
+// One noise octave sampled at every block column of a chunk.
+// NoiseGenerator only evaluates single points, so the grid hoists the
+// coordinate math out of the per sample loop: each coordinate is divided
+// once per row instead of once per sample. Values are bit-identical to
+// calling gen.noise per column with the same coordinates.
+struct NoiseGrid
+{
+	static const int SIZE = Chunk::EDGE_SIZE;
+
+	double values[SIZE][SIZE]; // [x][z]
+
+	// values[x][z] = gen.noise((origin_x + x) / scale, (origin_z + z) / scale)
+	void fill(NoiseGenerator const &gen, int origin_x, int origin_z, double scale);
+};
@@ -0,0 +1,97 @@
+#include "parallel.hpp"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+	if (thread_count == 0)
+		thread_count = std::thread::hardware_concurrency();
+
+	for (size_t i = 1; i < thread_count; ++i)
+		threads.emplace_back([this]() { worker_main(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		stopping = true;
+	}
+
+	work_cv.notify_all();
+
+	for (auto &thread : threads)
+		thread.join();
+}
+
+void ThreadPool::run(size_t count, std::function<void(size_t)> const &func)
+{
+	if (threads.empty() || count <= 1)
+	{
+		for (size_t i = 0; i < count; ++i)
+			func(i);
+
+		return;
+	}
+
+	std::lock_guard run_lock(run_mutex);
+
+	{
+		std::lock_guard lock(mutex);
+		work = &func;
+		work_count = count;
+		finished = 0;
+		next = 0;
+		generation += 1;
+	}
+
+	work_cv.notify_all();
+	take_work(func, count);
+
+	// Every worker takes part in every loop, so none can pick up func
+	// after it went out of scope.
+	std::unique_lock lock(mutex);
+	done_cv.wait(lock, [this]() { return finished == threads.size(); });
+	work = nullptr;
+}
+
+void ThreadPool::take_work(std::function<void(size_t)> const &func, size_t count)
+{
+	for (size_t i = next++; i < count; i = next++)
+		func(i);
+}
+
+void ThreadPool::worker_main()
+{
+	uint64_t seen = 0;
+
+	while (true)
+	{
+		std::function<void(size_t)> const *func;
+		size_t count;
+
+		{
+			std::unique_lock lock(mutex);
+			work_cv.wait(lock, [&]() { return stopping || generation != seen; });
+
+			if (stopping)
+				return;
+
+			seen = generation;
+			func = work;
+			count = work_count;
+		}
+
+		take_work(*func, count);
+
+		{
+			std::lock_guard lock(mutex);
+			finished += 1;
+		}
+
+		done_cv.notify_one();
+	}
+}
+
+void parallel_for(ThreadPool &pool, size_t count, std::function<void(size_t)> const &func)
+{
+	pool.run(count, func);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads kept alive between parallel loops, so loops run during
+// play do not start threads every frame. One loop runs at a time, func
+// must not start another loop on the same pool.
+struct ThreadPool
+{
+	// thread_count counts the calling thread, 0 uses all hardware threads.
+	explicit ThreadPool(size_t thread_count = 0);
+	~ThreadPool();
+
+	// Threads a loop runs on, the caller included.
+	size_t thread_count() const
+	{
+		return threads.size() + 1;
+	}
+
+	// Calls func(i) for every i in [0, count), returns when all calls are done.
+	void run(size_t count, std::function<void(size_t)> const &func);
+
+private:
+
+	void worker_main();
+	// Calls func for indices left in the current loop.
+	void take_work(std::function<void(size_t)> const &func, size_t count);
+
+	std::mutex run_mutex; // held by the caller for a whole loop
+
+	std::mutex mutex;
+	std::condition_variable work_cv;
+	std::condition_variable done_cv;
+	std::function<void(size_t)> const *work = nullptr;
+	size_t work_count = 0;
+	uint64_t generation = 0; // loops started
+	size_t finished = 0;     // workers done with the current loop
+	bool stopping = false;
+
+	std::atomic<size_t> next = 0;
+	std::vector<std::thread> threads;
+};
+
+// Calls func(i) for every i in [0, count) on the threads of pool, returns
+// when all calls are done.
+void parallel_for(ThreadPool &pool, size_t count, std::function<void(size_t)> const &func);
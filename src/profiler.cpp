@@ -0,0 +1,197 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace
+{
+
+// Single writer ring. An event is two words, the stage in the top byte of
+// the first, so the collector never sees a half written field and can drop
+// slots that were overwritten while it copied them.
+struct ThreadRing
+{
+	uint32_t thread = 0;
+	std::atomic<bool> in_use = true;
+	std::atomic<uint64_t> head = 0; // events written
+	uint64_t tail = 0;              // events collected, only touched by collect
+
+	std::atomic<uint64_t> starts[Profiler::RING_SIZE];
+	std::atomic<uint64_t> ends[Profiler::RING_SIZE];
+};
+
+const int STAGE_SHIFT = 56;
+const uint64_t TIME_MASK = (1ull << STAGE_SHIFT) - 1;
+
+std::mutex rings_mutex;
+std::vector<std::unique_ptr<ThreadRing>> rings;
+
+// Hands the ring to the next new thread when this one exits.
+struct RingOwner
+{
+	ThreadRing *ring = nullptr;
+
+	~RingOwner()
+	{
+		if (ring)
+			ring->in_use.store(false, std::memory_order_release);
+	}
+};
+
+thread_local RingOwner ring_owner;
+
+ThreadRing &thread_ring()
+{
+	if (ring_owner.ring)
+		return *ring_owner.ring;
+
+	std::lock_guard lock(rings_mutex);
+
+	for (auto &ring : rings)
+	{
+		if (!ring->in_use.load(std::memory_order_acquire))
+		{
+			ring->in_use.store(true, std::memory_order_relaxed);
+			ring_owner.ring = ring.get();
+			return *ring;
+		}
+	}
+
+	auto ring = std::make_unique<ThreadRing>();
+	ring->thread = (uint32_t)rings.size();
+	ring_owner.ring = ring.get();
+	rings.push_back(std::move(ring));
+	return *ring_owner.ring;
+}
+
+} // namespace
+
+uint64_t Profiler::now_ns()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void Profiler::record(ProfileStage stage, uint64_t start_ns, uint64_t end_ns)
+{
+	ThreadRing &ring = thread_ring();
+	uint64_t head = ring.head.load(std::memory_order_relaxed);
+	size_t slot = head % RING_SIZE;
+
+	ring.starts[slot].store((uint64_t)stage << STAGE_SHIFT | (start_ns & TIME_MASK), std::memory_order_relaxed);
+	ring.ends[slot].store(end_ns & TIME_MASK, std::memory_order_relaxed);
+	ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::collect(std::vector<ProfileEvent> &events)
+{
+	std::lock_guard lock(rings_mutex);
+
+	for (auto &ring : rings)
+	{
+		uint64_t head = ring->head.load(std::memory_order_acquire);
+		uint64_t from = head > RING_SIZE ? std::max(ring->tail, head - RING_SIZE) : ring->tail;
+		size_t first = events.size();
+
+		for (uint64_t i = from; i < head; ++i)
+		{
+			uint64_t start = ring->starts[i % RING_SIZE].load(std::memory_order_relaxed);
+			uint64_t end = ring->ends[i % RING_SIZE].load(std::memory_order_relaxed);
+
+			events.push_back({ (ProfileStage)(start >> STAGE_SHIFT), ring->thread, start & TIME_MASK, end });
+		}
+
+		// The writer may have lapped the copy, drop slots it could have reused.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t written = ring->head.load(std::memory_order_relaxed);
+
+		if (written >= RING_SIZE && written - RING_SIZE + 1 > from)
+		{
+			size_t overwritten = (size_t)std::min(written - RING_SIZE + 1 - from, head - from);
+			events.erase(events.begin() + first, events.begin() + first + overwritten);
+		}
+
+		ring->tail = head;
+	}
+}
+
+char const *Profiler::stage_name(ProfileStage stage)
+{
+	switch (stage)
+	{
+	case ProfileStage::Generate: return "Generate";
+	case ProfileStage::Faces:    return "Faces";
+	case ProfileStage::Mesh:     return "Mesh";
+	case ProfileStage::Upload:   return "Upload";
+	case ProfileStage::Cull:     return "Cull";
+	case ProfileStage::Draw:     return "Draw";
+	}
+
+	return "Unknown";
+}
+
+bool Profiler::write_csv(std::filesystem::path const &path, std::span<ProfileEvent const> events)
+{
+	FILE *file = fopen(path.string().c_str(), "w");
+	if (!file)
+		return false;
+
+	uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+	for (auto const &event : events)
+		origin = std::min(origin, event.start_ns);
+
+	fprintf(file, "stage,thread,start_ms,duration_ms\n");
+
+	for (auto const &event : events)
+	{
+		fprintf(file, "%s,%u,%.6f,%.6f\n",
+			stage_name(event.stage),
+			event.thread,
+			(event.start_ns - origin) / 1e6,
+			(event.end_ns - event.start_ns) / 1e6);
+	}
+
+	return fclose(file) == 0;
+}
+
+bool Profiler::write_chrome_trace(std::filesystem::path const &path, std::span<ProfileEvent const> events)
+{
+	FILE *file = fopen(path.string().c_str(), "w");
+	if (!file)
+		return false;
+
+	uint64_t origin = events.empty() ? 0 : events.front().start_ns;
+	for (auto const &event : events)
+		origin = std::min(origin, event.start_ns);
+
+	fprintf(file, "{\"traceEvents\":[\n");
+
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		auto const &event = events[i];
+
+		fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			stage_name(event.stage),
+			event.thread,
+			(event.start_ns - origin) / 1e3,
+			(event.end_ns - event.start_ns) / 1e3,
+			i + 1 < events.size() ? "," : "");
+	}
+
+	fprintf(file, "]}\n");
+	return fclose(file) == 0;
+}
+
+void ProfileHistory::add_frame(std::span<ProfileEvent const> events)
+{
+	frame = (frame + 1) % FRAMES;
+
+	for (size_t s = 0; s < PROFILE_STAGE_MAX; ++s)
+		stage_ms[s][frame] = 0.0f;
+
+	for (auto const &event : events)
+		stage_ms[(size_t)event.stage][frame] += float((event.end_ns - event.start_ns) / 1e6);
+}
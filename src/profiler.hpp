@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+enum class ProfileStage : uint8_t
+{
+	Generate, // World::load_chunks, region reads and generation
+	Faces,    // face masks of mesh jobs
+	Mesh,     // greedy meshing and vertex emission of mesh jobs
+	Upload,   // Chunk::load_mesh
+	Cull,     // World::find_reachable_chunks
+	Draw,     // draw loop of World::on_render
+};
+
+static inline const size_t PROFILE_STAGE_MAX = 6;
+
+struct ProfileEvent
+{
+	ProfileStage stage;
+	uint32_t thread; // in order of the first event recorded by each thread
+	uint64_t start_ns; // Profiler::now_ns
+	uint64_t end_ns;
+};
+
+// Scoped timers for the hot paths, recorded into per thread ring buffers
+// without locks. Disabled, a scope costs one relaxed atomic load.
+// Events not collected within RING_SIZE newer events of the same thread
+// are dropped.
+struct Profiler
+{
+	static const size_t RING_SIZE = 4096;
+
+	static inline std::atomic<bool> enabled = false;
+
+	static uint64_t now_ns();
+	static void record(ProfileStage stage, uint64_t start_ns, uint64_t end_ns);
+	// Appends the events recorded since the last call.
+	static void collect(std::vector<ProfileEvent> &events);
+
+	static char const *stage_name(ProfileStage stage);
+
+	static bool write_csv(std::filesystem::path const &path, std::span<ProfileEvent const> events);
+	// Chrome trace event format, opens in chrome://tracing and Perfetto.
+	static bool write_chrome_trace(std::filesystem::path const &path, std::span<ProfileEvent const> events);
+};
+
+struct ProfileScope
+{
+	explicit ProfileScope(ProfileStage stage)
+		: stage(stage)
+		, start_ns(Profiler::enabled.load(std::memory_order_relaxed) ? Profiler::now_ns() : 0)
+	{
+	}
+
+	~ProfileScope()
+	{
+		if (start_ns)
+			Profiler::record(stage, start_ns, Profiler::now_ns());
+	}
+
+	ProfileScope(ProfileScope const &) = delete;
+	ProfileScope &operator=(ProfileScope const &) = delete;
+
+	ProfileStage stage;
+	uint64_t start_ns;
+};
+
+// Milliseconds spent per stage in the last FRAMES frames, summed over all threads.
+struct ProfileHistory
+{
+	static const size_t FRAMES = 240;
+
+	float stage_ms[PROFILE_STAGE_MAX][FRAMES]{};
+	size_t frame = 0; // slot of the latest frame
+
+	void add_frame(std::span<ProfileEvent const> events);
+};
@@ -0,0 +1,182 @@
+#include "region.hpp"
+
+#include "chunk_codec.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static int floor_div(int a, int b)
+{
+	return a >= 0 ? a / b : (a - b + 1) / b;
+}
+
+RegionFile::~RegionFile()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+#else
+	if (data)
+		munmap((void *)data, size);
+	if (fd != -1)
+		close(fd);
+#endif
+}
+
+std::unique_ptr<RegionFile> RegionFile::open(std::filesystem::path const &path, uint32_t seed, uint32_t generator)
+{
+	std::unique_ptr<RegionFile> region{ new RegionFile() };
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	region->file = file;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		return nullptr;
+
+	region->size = (size_t)file_size.QuadPart;
+	region->mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!region->mapping)
+		return nullptr;
+
+	region->data = (uint8_t const *)MapViewOfFile(region->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!region->data)
+		return nullptr;
+#else
+	region->fd = ::open(path.c_str(), O_RDONLY);
+	if (region->fd == -1)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(region->fd, &st) != 0 || st.st_size == 0)
+		return nullptr;
+
+	region->size = (size_t)st.st_size;
+	void *mapped = mmap(nullptr, region->size, PROT_READ, MAP_PRIVATE, region->fd, 0);
+	if (mapped == MAP_FAILED)
+		return nullptr;
+
+	region->data = (uint8_t const *)mapped;
+#endif
+
+	size_t table_end = sizeof(RegionHeader) + ENTRY_COUNT * sizeof(RegionEntry);
+	if (region->size < table_end)
+		return nullptr;
+
+	RegionHeader header;
+	memcpy(&header, region->data, sizeof(header));
+
+	if (header.magic != MAGIC || header.version != VERSION || header.region_size != REGION_SIZE)
+		return nullptr;
+
+	if (header.seed != seed || header.generator != generator)
+		return nullptr;
+
+	return region;
+}
+
+bool RegionFile::write(std::filesystem::path const &path, std::vector<std::vector<uint8_t>> const &payloads, uint32_t seed, uint32_t generator)
+{
+	RegionHeader header{ MAGIC, VERSION, REGION_SIZE, seed, generator, 0 };
+	std::vector<RegionEntry> entries(ENTRY_COUNT);
+
+	size_t offset = sizeof(RegionHeader) + ENTRY_COUNT * sizeof(RegionEntry);
+
+	for (size_t i = 0; i < ENTRY_COUNT && i < payloads.size(); ++i)
+	{
+		if (payloads[i].empty())
+			continue;
+
+		if (offset + payloads[i].size() > UINT32_MAX)
+			return false;
+
+		entries[i] = { (uint32_t)offset, (uint32_t)payloads[i].size() };
+		offset += payloads[i].size();
+	}
+
+	std::filesystem::path temp_path = path;
+	temp_path += ".tmp";
+
+	FILE *file = fopen(temp_path.string().c_str(), "wb");
+	if (!file)
+		return false;
+
+	bool ok =
+		fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(entries.data(), sizeof(RegionEntry), entries.size(), file) == entries.size();
+
+	for (size_t i = 0; ok && i < ENTRY_COUNT && i < payloads.size(); ++i)
+		if (!payloads[i].empty())
+			ok = fwrite(payloads[i].data(), 1, payloads[i].size(), file) == payloads[i].size();
+
+	ok = (fclose(file) == 0) && ok;
+
+	std::error_code error;
+	if (ok)
+		std::filesystem::rename(temp_path, path, error);
+
+	if (!ok || error)
+	{
+		std::filesystem::remove(temp_path, error);
+		return false;
+	}
+
+	return true;
+}
+
+ivec3 RegionFile::region_of(ivec3 chunk_pos)
+{
+	return ivec3{
+		floor_div(chunk_pos.x, REGION_SIZE),
+		floor_div(chunk_pos.y, REGION_SIZE),
+		floor_div(chunk_pos.z, REGION_SIZE),
+	};
+}
+
+size_t RegionFile::entry_index(ivec3 chunk_pos)
+{
+	ivec3 local = chunk_pos - region_of(chunk_pos) * REGION_SIZE;
+	return ((size_t)local.x * REGION_SIZE + local.y) * REGION_SIZE + local.z;
+}
+
+std::filesystem::path RegionFile::file_name(ivec3 region)
+{
+	return "r." + std::to_string(region.x) + "." + std::to_string(region.y) + "." + std::to_string(region.z) + ".blkr";
+}
+
+std::span<uint8_t const> RegionFile::payload(ivec3 chunk_pos) const
+{
+	RegionEntry entry;
+	memcpy(&entry, data + sizeof(RegionHeader) + entry_index(chunk_pos) * sizeof(RegionEntry), sizeof(entry));
+
+	if (entry.size == 0 || entry.offset > size || entry.size > size - entry.offset)
+		return {};
+
+	return { data + entry.offset, entry.size };
+}
+
+bool RegionFile::load(ivec3 chunk_pos, BlockStorage &blocks) const
+{
+	auto bytes = payload(chunk_pos);
+	return !bytes.empty() && ChunkCodec::decode(bytes.data(), bytes.size(), blocks);
+}
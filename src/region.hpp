@@ -0,0 +1,71 @@
+#pragma once
+
+#include "block_storage.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Region files store a cube of REGION_SIZE^3 chunks:
+//   RegionHeader
+//   RegionEntry entries[REGION_SIZE^3], see RegionFile::entry_index
+//   chunk payloads, see ChunkCodec
+// All values are little endian.
+struct RegionHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t region_size;
+	uint32_t seed;      // of the generator the chunks around stored ones come from
+	uint32_t generator; // version of that generator
+	uint32_t reserved;
+};
+
+struct RegionEntry
+{
+	uint32_t offset; // from the start of the file
+	uint32_t size;   // 0 when the chunk is not stored
+};
+
+// Read only view of a memory mapped region file. Chunks decode straight
+// from the mapping, so lookups from several threads are safe.
+struct RegionFile
+{
+	static const int REGION_SIZE = 16;
+	static const size_t ENTRY_COUNT = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+	static const uint32_t MAGIC = 'B' | ('L' << 8) | ('K' << 16) | ('R' << 24);
+	static const uint32_t VERSION = 3;
+
+	RegionFile(RegionFile const &) = delete;
+	RegionFile &operator=(RegionFile const &) = delete;
+	~RegionFile();
+
+	// Returns null when the file does not exist, is not a valid region file
+	// or was written for another seed or generator version.
+	static std::unique_ptr<RegionFile> open(std::filesystem::path const &path, uint32_t seed, uint32_t generator);
+	// payloads are indexed by entry_index, empty ones are not stored.
+	// Writes to a temporary file first and replaces path, the file must not be open.
+	static bool write(std::filesystem::path const &path, std::vector<std::vector<uint8_t>> const &payloads, uint32_t seed, uint32_t generator);
+
+	static ivec3 region_of(ivec3 chunk_pos);
+	static size_t entry_index(ivec3 chunk_pos);
+	static std::filesystem::path file_name(ivec3 region);
+
+	// Empty when the chunk is not stored.
+	std::span<uint8_t const> payload(ivec3 chunk_pos) const;
+	bool load(ivec3 chunk_pos, BlockStorage &blocks) const;
+
+private:
+
+	RegionFile() = default;
+
+	uint8_t const *data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void *file = nullptr;
+	void *mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+};
@@ -1,16 +1,678 @@
 #include "world.hpp"
 
+#include "chunk_codec.hpp"
+#include "noise_grid.hpp"
+#include "parallel.hpp"
+#include "profiler.hpp"
+
 #include "gfxengine/noise_generator.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
+static const ivec3 directions[DIRECTION_MAX]{ {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1} };
+
 void World::on_render(RenderParams const &params)
 {
+	if (!mesher)
+		mesher = std::make_unique<ChunkMesher>();
+
 	for (auto &chunk : chunks)
-		chunk.second->on_render(params.add_offset(chunk.first * Chunk::EDGE_SIZE));
+	{
+		if (int lod = select_lod(chunk.first, params.camera_pos); lod != chunk.second->lod)
+		{
+			chunk.second->lod = lod;
+			chunk.second->dirty = true;
+
+			// Borders against this chunk change between hidden and skirt.
+			mark_neighbours_dirty(chunk.first);
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	auto deadline = std::chrono::steady_clock::time_point::max();
+
+	if (mesh_budget_ms > 0.0f)
+		deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float, std::milli>(mesh_budget_ms));
+
+	mesh_stats = {};
+
+	// Edits show up in the same frame, whatever the budget.
+	for (auto &job : mesh_edited_chunks(params.materials))
+		upload_mesh(params, *job);
+
+	collect_meshes();
+
+	{
+		ProfileScope scope(ProfileStage::Upload);
+
+		size_t done = 0;
+
+		for (; done < completed_meshes.size(); ++done)
+		{
+			if (mesh_stats.uploaded > 0 && std::chrono::steady_clock::now() >= deadline)
+				break;
+
+			if (upload_mesh(params, *completed_meshes[done]))
+				mesh_stats.uploaded += 1;
+		}
+
+		completed_meshes.erase(completed_meshes.begin(), completed_meshes.begin() + done);
+	}
+
+	schedule_meshes(params.camera_pos, params.frustum, params.materials, deadline);
+
+	mesh_stats.pending_uploads = completed_meshes.size();
+	mesh_stats.used_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	render_stats = {};
+	frame_index += 1;
+
+	if (cave_culling)
+		find_reachable_chunks(params.camera_pos, params.frustum);
+
+	{
+		ProfileScope scope(ProfileStage::Draw);
+
+		for (auto &chunk : chunks)
+		{
+			if (!chunk.second->has_solid() || (params.frustum && !chunk.second->is_visible(*params.frustum, chunk.first)))
+			{
+				render_stats.culled_chunks += 1;
+				continue;
+			}
+
+			if (cave_culling && chunk.second->reached_frame != frame_index)
+			{
+				render_stats.occluded_chunks += 1;
+				continue;
+			}
+
+			render_stats.visible_chunks += 1;
+			chunk.second->used_frame = frame_index;
+			render_stats.triangles += chunk.second->mesh_quads * 2;
+			render_stats.full_triangles += chunk.second->mesh_full_quads * 2;
+			chunk.second->on_render(params.at_chunk(chunk.first));
+		}
+	}
+
+	if (cold_frames > 0)
+	{
+		size_t freezes = 0;
+
+		for (auto &chunk : chunks)
+		{
+			if (freezes == freezes_per_frame)
+				break;
+
+			// Uniform chunks store no block data, there is nothing to compress.
+			if (!chunk.second->is_cold() && chunk.second->blocks.bits != 0 && !chunk.second->dirty && frame_index - chunk.second->used_frame > cold_frames)
+			{
+				chunk.second->freeze();
+				freezes += 1;
+			}
+		}
+	}
+}
+
+void World::find_reachable_chunks(vec3 camera_pos, Frustum const *frustum)
+{
+	ProfileScope scope(ProfileStage::Cull);
+
+	if (chunks.empty())
+		return;
+
+	ivec3 start = math::floor(camera_pos / (float)Chunk::EDGE_SIZE);
+
+	// Positions without a chunk are open air, keep the search to one chunk
+	// around the loaded area plus the camera.
+	ivec3 bounds_min = start;
+	ivec3 bounds_max = start;
+
+	for (auto const &chunk : chunks)
+	{
+		bounds_min = { math::min(bounds_min.x, chunk.first.x - 1), math::min(bounds_min.y, chunk.first.y - 1), math::min(bounds_min.z, chunk.first.z - 1) };
+		bounds_max = { math::max(bounds_max.x, chunk.first.x + 1), math::max(bounds_max.y, chunk.first.y + 1), math::max(bounds_max.z, chunk.first.z + 1) };
+	}
+
+	struct Step
+	{
+		ivec3 pos;
+		int entered;        // face of pos the search came through, -1 at the camera
+		uint8_t directions; // directions travelled so far, never turn back against one
+	};
+
+	std::vector<Step> queue{ { start, -1, 0 } };
+	std::unordered_set<ivec3> visited{ start };
+
+	for (size_t i = 0; i < queue.size(); ++i)
+	{
+		Step step = queue[i];
+		Chunk *chunk = nullptr;
+
+		if (auto it = chunks.find(step.pos); it != chunks.end())
+		{
+			chunk = it->second.get();
+			chunk->reached_frame = frame_index;
+		}
+
+		for (int f = 0; f < DIRECTION_MAX; ++f)
+		{
+			if (step.directions & (1 << (int)opposite((Direction)f)))
+				continue;
+
+			if (chunk && step.entered >= 0 && !(chunk->face_connections[step.entered] & (1 << f)))
+				continue;
+
+			ivec3 next = step.pos + directions[f];
+
+			if (next.x < bounds_min.x || next.y < bounds_min.y || next.z < bounds_min.z ||
+				next.x > bounds_max.x || next.y > bounds_max.y || next.z > bounds_max.z)
+			{
+				continue;
+			}
+
+			if (frustum)
+			{
+				vec3 origin = vec3(next * (int)Chunk::EDGE_SIZE);
+				if (!frustum->intersects(origin, origin + (float)Chunk::EDGE_SIZE))
+					continue;
+			}
+
+			if (!visited.insert(next).second)
+				continue;
+
+			queue.push_back({ next, (int)opposite((Direction)f), uint8_t(step.directions | (1 << f)) });
+		}
+	}
+}
+
+size_t World::schedule_meshes(vec3 camera_pos, Frustum const *frustum, MaterialManager const &materials, std::chrono::steady_clock::time_point deadline)
+{
+	if (!mesher)
+		mesher = std::make_unique<ChunkMesher>();
+
+	ivec3 camera_chunk = math::floor(camera_pos / (float)Chunk::EDGE_SIZE);
+	remesh_queue.clear();
+
+	for (auto &chunk : chunks)
+	{
+		if (!chunk.second->dirty)
+			continue;
+
+		if (!needs_mesh(chunk.first, *chunk.second))
+		{
+			chunk.second->dirty = false;
+			chunk.second->mesh_version = ++mesh_version; // drops jobs still in flight
+			chunk.second->clear_mesh();
+			mesh_stats.skipped += 1;
+			continue;
+		}
+
+		ivec3 d = chunk.first - camera_chunk;
+		uint64_t priority = uint64_t(d.x * d.x + d.y * d.y + d.z * d.z);
+
+		if (frustum && !chunk.second->is_visible(*frustum, chunk.first))
+			priority |= 1ull << 32;
+
+		remesh_queue.push_back({ priority, chunk.first, chunk.second.get() });
+	}
+
+	// Min heap, only the submitted part of the queue gets sorted.
+	auto later = [](RemeshRequest const &a, RemeshRequest const &b) { return a.priority > b.priority; };
+	std::make_heap(remesh_queue.begin(), remesh_queue.end(), later);
+
+	size_t submitted = 0;
+
+	while (!remesh_queue.empty() && (max_mesh_jobs_in_flight == 0 || mesh_jobs_in_flight < max_mesh_jobs_in_flight))
+	{
+		if (submitted > 0 && std::chrono::steady_clock::now() >= deadline)
+			break;
+
+		std::pop_heap(remesh_queue.begin(), remesh_queue.end(), later);
+		RemeshRequest request = remesh_queue.back();
+		remesh_queue.pop_back();
+
+		mesher->submit(create_mesh_job(request.pos, *request.chunk, materials));
+		mesh_jobs_in_flight += 1;
+		submitted += 1;
+	}
+
+	mesh_stats.queued = remesh_queue.size();
+	mesh_stats.in_flight = mesh_jobs_in_flight;
+	mesh_stats.submitted = submitted;
+	return submitted;
+}
+
+void World::collect_meshes()
+{
+	if (!mesher)
+		return;
+
+	size_t collected = completed_meshes.size();
+	mesher->collect(completed_meshes);
+	mesh_jobs_in_flight -= completed_meshes.size() - collected;
+}
+
+bool World::needs_mesh(ivec3 pos, Chunk const &chunk) const
+{
+	if (!chunk.has_solid())
+		return false;
+
+	if (!chunk.is_uniform_solid())
+		return true;
+
+	// Buried, every neighbour covers its side. Neighbours at another level
+	// of detail leave their side open, see create_mesh_job. Reduced sides
+	// are only sure to stay solid for uniform solid neighbours.
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+	{
+		auto it = chunks.find(pos + directions[f]);
+		if (it == chunks.end() || it->second->lod != chunk.lod || !it->second->is_side_solid(opposite((Direction)f)))
+			return true;
+
+		if (chunk.lod > 0 && !it->second->is_uniform_solid())
+			return true;
+	}
+
+	return false;
+}
+
+bool World::upload_mesh(RenderParams const &params, ChunkMeshJob &job)
+{
+	auto it = chunks.find(job.chunk_pos);
+	if (it == chunks.end() || it->second->mesh_version != job.version)
+		return false;
+
+	if (job.vertices.empty())
+	{
+		it->second->clear_mesh();
+		return true;
+	}
+
+	it->second->load_mesh(params.at_chunk(job.chunk_pos), job.vertices);
+	it->second->mesh_quads = job.quads;
+	it->second->mesh_full_quads = job.full_quads;
+	return true;
+}
+
+int World::select_lod(ivec3 pos, vec3 camera_pos) const
+{
+	if (lod_distance <= 0)
+		return 0;
+
+	ivec3 camera_chunk = math::floor(camera_pos / (float)Chunk::EDGE_SIZE);
+	ivec3 d = pos - camera_chunk;
+	int distance2 = d.x * d.x + d.y * d.y + d.z * d.z;
+
+	int lod = 0;
+	while (lod < Chunk::LOD_MAX && distance2 >= (lod + 1) * (lod + 1) * lod_distance * lod_distance)
+		lod += 1;
+
+	return lod;
+}
+
+std::unique_ptr<ChunkMeshJob> World::create_mesh_job(ivec3 pos, Chunk &chunk, MaterialManager const &materials)
+{
+	chunk.thaw();
+	chunk.dirty = false;
+	chunk.mesh_version = ++mesh_version;
+
+	auto job = std::make_unique<ChunkMeshJob>();
+	job->chunk_pos = pos;
+	job->version = chunk.mesh_version;
+	job->blocks = chunk.blocks;
+	job->materials = &materials;
+	job->lod = chunk.lod;
+	job->full_quads = chunk.mesh_full_quads;
+	job->solidity.set_center(chunk);
+	job->light.set_center(chunk);
+
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+	{
+		auto it = chunks.find(pos + directions[f]);
+		if (it == chunks.end())
+			continue;
+
+		job->light.set_border((Direction)f, *it->second);
+
+		// Neighbours meshed at another level of detail do not cover our border,
+		// their faces are kept open towards us.
+		if (it->second->lod == chunk.lod)
+			job->solidity.set_border((Direction)f, *it->second, chunk.lod);
+	}
+
+	return job;
+}
+
+void World::mark_neighbours_dirty(ivec3 pos)
+{
+	for (auto direction : directions)
+		if (auto it = chunks.find(pos + direction); it != chunks.end() && it->second->has_solid())
+			it->second->dirty = true;
+}
+
+ivec3 World::chunk_of(ivec3 world_pos)
+{
+	static_assert(Chunk::EDGE_SIZE == 16);
+	return { world_pos.x >> 4, world_pos.y >> 4, world_pos.z >> 4 };
+}
+
+bool World::is_solid_block(ivec3 world_pos) const
+{
+	auto it = chunks.find(chunk_of(world_pos));
+	if (it == chunks.end())
+		return false;
+
+	return it->second->is_solid_at(world_pos.x & Chunk::EDGE_LAST, world_pos.y & Chunk::EDGE_LAST, world_pos.z & Chunk::EDGE_LAST);
+}
+
+RaycastHit World::raycast(vec3 origin, vec3 dir, float max_dist) const
+{
+	// Amanatides-Woo on two levels. Both compute boundary distances the same
+	// way from the origin, so the two walks agree on which boundary comes
+	// first, and cells are found from the current block position.
+	float const o[3]{ origin.x, origin.y, origin.z };
+	float d[3]{ dir.x, dir.y, dir.z };
+
+	float length = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	if (!(length > 0.0f) || chunks.empty())
+		return {};
+
+	float inv[3];
+	int step[3];
+	int dominant = 0;
+
+	for (int a = 0; a < 3; ++a)
+	{
+		d[a] /= length;
+		inv[a] = d[a] != 0.0f ? 1.0f / d[a] : 0.0f;
+		step[a] = d[a] > 0.0f ? 1 : -1;
+
+		if (std::abs(d[a]) > std::abs(d[dominant]))
+			dominant = a;
+	}
+
+	// Distance to the next boundary of cells of size cell along axis a.
+	auto boundary = [&](int a, int cell_start, int cell) {
+		if (d[a] == 0.0f)
+			return INFINITY;
+
+		int next = step[a] > 0 ? cell_start + cell : cell_start;
+		return (float(next) - o[a]) * inv[a];
+	};
+
+	int block[3]{ (int)std::floor(o[0]), (int)std::floor(o[1]), (int)std::floor(o[2]) };
+	float t = 0.0f;
+	Direction face = (Direction)(dominant * 2 + (step[dominant] > 0 ? 0 : 1));
+
+	ChunkCache cache{ chunks };
+
+	const int EDGE_SIZE = Chunk::EDGE_SIZE;
+
+	while (t <= max_dist)
+	{
+		ivec3 chunk_pos = chunk_of({ block[0], block[1], block[2] });
+		Chunk const *chunk = cache.get(chunk_pos);
+
+		int const cell_start[3]{ chunk_pos.x * EDGE_SIZE, chunk_pos.y * EDGE_SIZE, chunk_pos.z * EDGE_SIZE };
+
+		if (!chunk || !chunk->has_solid())
+		{
+			// Nothing to hit, jump to where the ray leaves the chunk.
+			int axis = 0;
+			float exit[3];
+
+			for (int a = 0; a < 3; ++a)
+			{
+				exit[a] = boundary(a, cell_start[a], EDGE_SIZE);
+				if (exit[a] < exit[axis])
+					axis = a;
+			}
+
+			t = exit[axis];
+			if (t > max_dist)
+				break;
+
+			for (int a = 0; a < 3; ++a)
+			{
+				if (a == axis)
+				{
+					block[a] = step[a] > 0 ? cell_start[a] + EDGE_SIZE : cell_start[a] - 1;
+				}
+				else
+				{
+					// Rounding may put the point just outside the chunk it is still in.
+					int b = (int)std::floor(o[a] + d[a] * t);
+					block[a] = std::clamp(b, cell_start[a], cell_start[a] + EDGE_SIZE - 1);
+				}
+			}
+
+			face = (Direction)(axis * 2 + (step[axis] > 0 ? 0 : 1));
+			continue;
+		}
+
+		// Blocks of this chunk until one is solid or the ray leaves it.
+		while (true)
+		{
+			int x = block[0] - cell_start[0];
+			int y = block[1] - cell_start[1];
+			int z = block[2] - cell_start[2];
+
+			if (x < 0 || x >= EDGE_SIZE || y < 0 || y >= EDGE_SIZE || z < 0 || z >= EDGE_SIZE)
+				break;
+
+			if (chunk->is_solid_at(x, y, z))
+			{
+				RaycastHit hit;
+				hit.hit = true;
+				hit.block = { block[0], block[1], block[2] };
+				hit.face = face;
+				hit.distance = t;
+				return hit;
+			}
+
+			int axis = 0;
+			float next[3];
+
+			for (int a = 0; a < 3; ++a)
+			{
+				next[a] = boundary(a, block[a], 1);
+				if (next[a] < next[axis])
+					axis = a;
+			}
+
+			t = next[axis];
+			if (t > max_dist)
+				return {};
+
+			block[axis] += step[axis];
+			face = (Direction)(axis * 2 + (step[axis] > 0 ? 0 : 1));
+		}
+	}
+
+	return {};
+}
+
+ThreadPool &World::thread_pool() const
+{
+	size_t wanted = thread_count ? thread_count : std::thread::hardware_concurrency();
+
+	if (!pool || pool->thread_count() != std::max<size_t>(wanted, 1))
+		pool = std::make_unique<ThreadPool>(wanted);
+
+	return *pool;
+}
+
+void World::raycast(std::span<Ray const> rays, std::span<RaycastHit> hits) const
+{
+	// Rays are handed out in groups, a ray alone is too short a task.
+	const size_t GROUP = 64;
+
+	parallel_for(thread_pool(), (rays.size() + GROUP - 1) / GROUP, [&](size_t group) {
+		size_t end = std::min(rays.size(), (group + 1) * GROUP);
+
+		for (size_t i = group * GROUP; i < end; ++i)
+			hits[i] = raycast(rays[i].origin, rays[i].dir, rays[i].max_dist);
+	});
+}
+
+ItemID World::get_block(ivec3 world_pos)
+{
+	auto it = chunks.find(chunk_of(world_pos));
+	if (it == chunks.end())
+		return ItemID::Air;
+
+	it->second->thaw();
+	return it->second->get_block(world_pos.x & Chunk::EDGE_LAST, world_pos.y & Chunk::EDGE_LAST, world_pos.z & Chunk::EDGE_LAST);
+}
+
+bool World::set_block(ivec3 world_pos, ItemID id)
+{
+	ivec3 chunk_pos = chunk_of(world_pos);
+	auto it = chunks.find(chunk_pos);
+	if (it == chunks.end())
+		return false;
+
+	Chunk &chunk = *it->second;
+	int x = world_pos.x & Chunk::EDGE_LAST;
+	int y = world_pos.y & Chunk::EDGE_LAST;
+	int z = world_pos.z & Chunk::EDGE_LAST;
+
+	// Edits to a corrupt chunk could never be saved.
+	if (!chunk.thaw())
+		return false;
+
+	ItemID old_id = chunk.get_block(x, y, z);
+	if (old_id == id)
+		return true;
+
+	bool was_solid = chunk.is_solid_at(x, y, z);
+	chunk.set_block(x, y, z, id);
+	chunk.refresh_block_solidity(x, y, z);
+	light.block_changed(*this, world_pos, old_id, id);
+
+	chunk.dirty = true;
+	chunk.modified = true;
+	edited_chunks.insert(chunk_pos);
+
+	if (was_solid == chunk.is_solid_at(x, y, z))
+		return true;
+
+	// Neighbours mesh their border against this block.
+	ivec3 local{ x, y, z };
+
+	for (int f = 0; f < DIRECTION_MAX; ++f)
+	{
+		ivec3 n = local + directions[f];
+		bool inside = n.x >= 0 && n.x < Chunk::EDGE_SIZE && n.y >= 0 && n.y < Chunk::EDGE_SIZE && n.z >= 0 && n.z < Chunk::EDGE_SIZE;
+		if (inside)
+			continue;
+
+		if (auto n_it = chunks.find(chunk_pos + directions[f]); n_it != chunks.end())
+		{
+			n_it->second->dirty = true;
+			edited_chunks.insert(n_it->first);
+		}
+	}
+
+	return true;
+}
+
+void World::set_blocks(std::span<BlockEdit const> edits)
+{
+	for (auto const &edit : edits)
+		set_block(edit.pos, edit.id);
+}
+
+std::vector<std::unique_ptr<ChunkMeshJob>> World::mesh_edited_chunks(MaterialManager const &materials)
+{
+	std::vector<std::unique_ptr<ChunkMeshJob>> jobs;
+
+	light.update(*this, light_steps_per_frame);
+	light.stats.relit_chunks = 0;
+
+	// Edited and relit chunks wait for the queues to run empty, so a relight
+	// spread over several frames shows up at once, with the edits that caused it.
+	if (!light.idle())
+		return jobs;
+
+	for (auto pos : light.changed_chunks)
+	{
+		if (edited_chunks.contains(pos))
+			continue;
+
+		if (auto it = chunks.find(pos); it != chunks.end() && it->second->has_solid())
+		{
+			it->second->dirty = true;
+			light.stats.relit_chunks += 1;
+		}
+	}
+
+	light.changed_chunks.clear();
+
+	for (auto pos : edited_chunks)
+	{
+		auto it = chunks.find(pos);
+		if (it == chunks.end())
+			continue;
+
+		// Edits may have removed the last block of an id, a chunk back to a
+		// single id takes the uniform paths again.
+		it->second->blocks.compact();
+		it->second->refresh_solid_bounds();
+		it->second->refresh_connectivity();
+
+		auto job = create_mesh_job(pos, *it->second, materials);
+		ChunkMesher::run(*job, edit_frame);
+		jobs.push_back(std::move(job));
+	}
+
+	edited_chunks.clear();
+	return jobs;
+}
+
+WorldMemoryStats World::memory_stats() const
+{
+	WorldMemoryStats stats;
+
+	for (auto const &chunk : chunks)
+	{
+		stats.chunks += 1;
+		stats.palette_entries += chunk.second->blocks.palette.size();
+		stats.block_bytes += chunk.second->blocks.memory_usage();
+		stats.dense_block_bytes += BlockStorage::VOLUME * sizeof(ItemID);
+		stats.chunk_bytes += chunk.second->memory_usage();
+		stats.light_bytes += chunk.second->light.memory_usage();
+
+		if (!chunk.second->has_solid())
+			stats.empty_chunks += 1;
+		else if (chunk.second->is_uniform_solid())
+			stats.uniform_solid_chunks += 1;
+
+		if (chunk.second->is_cold())
+		{
+			stats.cold_chunks += 1;
+			stats.cold_block_bytes += chunk.second->cold_blocks.capacity();
+			stats.block_bytes += chunk.second->cold_blocks.capacity();
+		}
+	}
+
+	stats.overflow_chunks = chunks.overflow_size();
+	return stats;
 }
 
 void World::init_random_chunks(std::mt19937 &rng, ivec3 from, ivec3 to, int count)
 {
 	chunks.clear();
+	load_queue.clear();
+	edited_chunks.clear();
+	unloaded_edits.clear();
+	stream_radius = -1;
 	std::uniform_int_distribution<std::mt19937::result_type> dist(0, Chunk::EDGE_SIZE - 1);
 
 	for (int x = from.x; x < to.x; ++x)
@@ -29,8 +691,7 @@ void World::init_random_chunks(std::mt19937 &rng, ivec3 from, ivec3 to, int coun
 						{
 							for (int _z = 0; _z < Chunk::EDGE_SIZE; ++_z)
 							{
-								chunk->blocks[_x][_y][_z].solid = true;
-								chunk->blocks[_x][_y][_z].id = ItemID::Dirt;
+								chunk->set_block(_x, _y, _z, ItemID::Dirt);
 							}
 						}
 					}
@@ -43,66 +704,366 @@ void World::init_random_chunks(std::mt19937 &rng, ivec3 from, ivec3 to, int coun
 						int _y = dist(rng);
 						int _z = dist(rng);
 
-						chunk->blocks[_x][_y][_z].solid = true;
-						chunk->blocks[_x][_y][_z].id = ItemID::Dirt;
+						chunk->set_block(_x, _y, _z, ItemID::Dirt);
 					}
 				}
 
-				chunk->refresh_visible_faces();
+				chunk->refresh_solidity();
 			}
 		}
 	}
 
-	for (auto &chunk : chunks)
-	{
-		static const ivec3 directions[DIRECTION_MAX]{ {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1} };
-
-		for (auto direction : directions)
-			if (auto it = chunks.find(chunk.first + direction); it != chunks.end())
-				chunk.second->hide_adjacent_chunk_faces(direction, *it->second);
-	}
+	light.relight(*this);
 }
 
 void World::init(NoiseGenerator const &gen, ivec3 from, ivec3 to)
 {
 	chunks.clear();
+	load_queue.clear();
+	edited_chunks.clear();
+	unloaded_edits.clear();
+	stream_radius = -1;
+
+	std::vector<ivec3> positions;
 
 	for (int x = from.x; x < to.x; ++x)
+		for (int y = from.y; y < to.y; ++y)
+			for (int z = from.z; z < to.z; ++z)
+				positions.push_back(ivec3{ x, y, z });
+
+	auto loaded = load_chunks(gen, positions);
+
+	for (size_t i = 0; i < positions.size(); ++i)
+		chunks.emplace(positions[i], std::move(loaded[i]));
+
+	light.relight(*this);
+}
+
+void World::open_regions(std::vector<ivec3> const &positions)
+{
+	if (region_dir.empty())
+		return;
+
+	for (auto pos : positions)
 	{
-		for (int z = from.x; z < to.z; ++z)
+		ivec3 region = RegionFile::region_of(pos);
+
+		if (!regions.contains(region))
+			regions.emplace(region, RegionFile::open(region_dir / RegionFile::file_name(region), seed, GENERATOR_VERSION));
+	}
+}
+
+std::unique_ptr<Chunk> World::read_chunk(ivec3 pos) const
+{
+	if (auto it = unloaded_edits.find(pos); it != unloaded_edits.end())
+	{
+		auto chunk = std::make_unique<Chunk>();
+		chunk->modified = true;
+
+		if (ChunkCodec::decode(it->second.data(), it->second.size(), chunk->blocks))
+			return chunk;
+
+		fprintf(stderr, "world: unsaved edits of chunk %d %d %d failed to decode, dropping them\n", pos.x, pos.y, pos.z);
+	}
+
+	if (auto it = regions.find(RegionFile::region_of(pos)); it != regions.end() && it->second)
+	{
+		auto chunk = std::make_unique<Chunk>();
+
+		if (it->second->load(pos, chunk->blocks))
+			return chunk;
+
+		if (!it->second->payload(pos).empty())
+			fprintf(stderr, "world: stored chunk %d %d %d failed to decode, generating it\n", pos.x, pos.y, pos.z);
+	}
+
+	return nullptr;
+}
+
+std::vector<std::unique_ptr<Chunk>> World::load_chunks(NoiseGenerator const &gen, std::vector<ivec3> const &positions)
+{
+	ProfileScope scope(ProfileStage::Generate);
+
+	open_regions(positions);
+
+	std::vector<std::unique_ptr<Chunk>> loaded(positions.size());
+
+	parallel_for(thread_pool(), positions.size(), [&](size_t i) {
+		loaded[i] = read_chunk(positions[i]);
+	});
+
+	// Heightmaps of the columns that still have chunks to generate.
+	std::unordered_map<ivec3, size_t> column_index;
+	std::vector<ivec3> columns;
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		// Unsaved edits move back into the chunk, still unsaved. Ones that
+		// failed to decode are dropped rather than saved later.
+		unloaded_edits.erase(positions[i]);
+
+		if (loaded[i])
 		{
-			int y = 0;
-			auto &chunk = chunks.emplace(ivec3{ x, y, z }, std::make_unique<Chunk>()).first->second;
+			if (!loaded[i]->modified)
+				stream_stats.region_loads += 1;
+
+			continue;
+		}
+
+		ivec3 column{ positions[i].x, 0, positions[i].z };
+		if (column_index.emplace(column, columns.size()).second)
+			columns.push_back(column);
+	}
+
+	std::vector<ColumnHeightmap> heightmaps(columns.size());
+
+	parallel_for(thread_pool(), columns.size(), [&](size_t i) {
+		heightmaps[i] = generate_heightmap(gen, columns[i].x, columns[i].z);
+	});
+
+	parallel_for(thread_pool(), positions.size(), [&](size_t i) {
+		if (!loaded[i])
+			loaded[i] = generate_chunk(heightmaps[column_index.at({ positions[i].x, 0, positions[i].z })], positions[i]);
+
+		loaded[i]->refresh_solidity();
+	});
+
+	return loaded;
+}
+
+bool World::save_regions()
+{
+	if (region_dir.empty())
+		return false;
+
+	std::error_code error;
+	std::filesystem::create_directories(region_dir, error);
+	if (error)
+		return false;
+
+	std::unordered_map<ivec3, std::vector<std::vector<uint8_t>>> payloads;
 
-			for (int _x = 0; _x < Chunk::EDGE_SIZE; ++_x)
+	for (auto const &chunk : chunks)
+	{
+		auto &region = payloads[RegionFile::region_of(chunk.first)];
+		region.resize(RegionFile::ENTRY_COUNT);
+
+		chunk.second->encode_blocks(region[RegionFile::entry_index(chunk.first)]);
+	}
+
+	for (auto const &edit : unloaded_edits)
+	{
+		auto &region = payloads[RegionFile::region_of(edit.first)];
+		region.resize(RegionFile::ENTRY_COUNT);
+		region[RegionFile::entry_index(edit.first)] = edit.second;
+	}
+
+	bool ok = true;
+
+	for (auto &region : payloads)
+	{
+		std::vector<ivec3> positions{ region.first * RegionFile::REGION_SIZE };
+		open_regions(positions);
+
+		// Keep chunks stored in the file that are not loaded.
+		if (auto const &file = regions.at(region.first))
+		{
+			for (int x = 0; x < RegionFile::REGION_SIZE; ++x)
 			{
-				for (int _z = 0; _z < Chunk::EDGE_SIZE; ++_z)
+				for (int y = 0; y < RegionFile::REGION_SIZE; ++y)
 				{
-					double val = (
-						(gen.noise((x * (int)Chunk::EDGE_SIZE + _x) / 64.0, (z * (int)Chunk::EDGE_SIZE + _z) / 64.0) + 1) / 2 * 1.00 +
-						(gen.noise((x * (int)Chunk::EDGE_SIZE + _x) / 32.0, (z * (int)Chunk::EDGE_SIZE + _z) / 32.0) + 1) / 2 * 0.50 +
-						(gen.noise((x * (int)Chunk::EDGE_SIZE + _x) / 16.0, (z * (int)Chunk::EDGE_SIZE + _z) / 16.0) + 1) / 2 * 0.25
-						) / 1.75;
-					int height = val * 15 + 1;
-
-					for (int _y = math::max(0, height - 5); _y < height; ++_y)
+					for (int z = 0; z < RegionFile::REGION_SIZE; ++z)
 					{
-						chunk->blocks[_x][_y][_z].solid = true;
-						chunk->blocks[_x][_y][_z].id = ItemID::Dirt;
+						ivec3 pos = region.first * RegionFile::REGION_SIZE + ivec3{ x, y, z };
+						auto &payload = region.second[RegionFile::entry_index(pos)];
+
+						if (payload.empty())
+						{
+							auto stored = file->payload(pos);
+							payload.assign(stored.begin(), stored.end());
+						}
 					}
 				}
 			}
+		}
+
+		// The mapping has to be closed before the file is replaced.
+		regions.erase(region.first);
+		ok = RegionFile::write(region_dir / RegionFile::file_name(region.first), region.second, seed, GENERATOR_VERSION) && ok;
+	}
+
+	// Keep the edits for another try when a region failed to write.
+	if (ok)
+	{
+		for (auto &chunk : chunks)
+			chunk.second->modified = false;
+
+		unloaded_edits.clear();
+	}
+
+	return ok;
+}
+
+ColumnHeightmap World::generate_heightmap(NoiseGenerator const &gen, int column_x, int column_z) const
+{
+	int origin_x = column_x * (int)Chunk::EDGE_SIZE;
+	int origin_z = column_z * (int)Chunk::EDGE_SIZE;
 
-			chunk->refresh_visible_faces();
+	NoiseGrid octaves[3];
+	octaves[0].fill(gen, origin_x, origin_z, 64.0);
+	octaves[1].fill(gen, origin_x, origin_z, 32.0);
+	octaves[2].fill(gen, origin_x, origin_z, 16.0);
+
+	ColumnHeightmap heightmap;
+	heightmap.min_height = INT_MAX;
+	heightmap.max_height = INT_MIN;
+
+	for (int _x = 0; _x < Chunk::EDGE_SIZE; ++_x)
+	{
+		for (int _z = 0; _z < Chunk::EDGE_SIZE; ++_z)
+		{
+			double val = (
+				(octaves[0].values[_x][_z] + 1) / 2 * 1.00 +
+				(octaves[1].values[_x][_z] + 1) / 2 * 0.50 +
+				(octaves[2].values[_x][_z] + 1) / 2 * 0.25
+				) / 1.75;
+			int height = val * (terrain_height - 1) + 1;
+
+			heightmap.heights[_x][_z] = height;
+			heightmap.min_height = math::min(heightmap.min_height, height);
+			heightmap.max_height = math::max(heightmap.max_height, height);
 		}
 	}
 
-	for (auto &chunk : chunks)
+	return heightmap;
+}
+
+std::unique_ptr<Chunk> World::generate_chunk(ColumnHeightmap const &heightmap, ivec3 pos)
+{
+	auto chunk = std::make_unique<Chunk>();
+	int bottom = pos.y * (int)Chunk::EDGE_SIZE;
+
+	if (heightmap.max_height <= bottom)
+		return chunk;
+
+	if (heightmap.min_height >= bottom + (int)Chunk::EDGE_SIZE)
 	{
-		static const ivec3 directions[DIRECTION_MAX]{ {-1,0,0}, {1,0,0}, {0,-1,0}, {0,1,0}, {0,0,-1}, {0,0,1} };
+		chunk->blocks.fill(ItemID::Dirt);
+		return chunk;
+	}
 
-		for (auto direction : directions)
-			if (auto it = chunks.find(chunk.first + direction); it != chunks.end())
-				chunk.second->hide_adjacent_chunk_faces(direction, *it->second);
+	uint8_t indices[BlockStorage::VOLUME];
+	size_t index = 0;
+
+	for (int _x = 0; _x < Chunk::EDGE_SIZE; ++_x)
+	{
+		for (int _y = 0; _y < Chunk::EDGE_SIZE; ++_y)
+		{
+			int y = bottom + _y;
+
+			for (int _z = 0; _z < Chunk::EDGE_SIZE; ++_z, ++index)
+				indices[index] = y < heightmap.heights[_x][_z];
+		}
 	}
+
+	chunk->blocks.assign({ ItemID::Air, ItemID::Dirt }, indices);
+	return chunk;
+}
+
+void World::stream(NoiseGenerator const &gen, vec3 camera_pos, int view_radius, int unload_radius)
+{
+	ivec3 center = math::floor(camera_pos / (float)Chunk::EDGE_SIZE);
+	center.y = 0;
+
+	auto distance2 = [&](ivec3 pos) {
+		ivec3 d = pos - center;
+		return d.x * d.x + d.z * d.z;
+	};
+
+	if (center != stream_center || view_radius != stream_radius)
+	{
+		stream_center = center;
+		stream_radius = view_radius;
+
+		std::vector<ivec3> unloaded;
+
+		for (auto it = chunks.begin(); it != chunks.end();)
+		{
+			if (distance2(it->first) > unload_radius * unload_radius)
+			{
+				// Generating the chunk again would drop its edits, load keeps them.
+				if (it->second->modified)
+				{
+					auto &payload = unloaded_edits[it->first];
+					payload.clear();
+					it->second->encode_blocks(payload);
+				}
+
+				unloaded.push_back(it->first);
+				it = chunks.erase(it);
+				stream_stats.unloads += 1;
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		// Neighbours of unloaded chunks had faces hidden against them.
+		for (auto pos : unloaded)
+			mark_neighbours_dirty(pos);
+
+		load_queue.clear();
+
+		for (int x = -view_radius; x <= view_radius; ++x)
+		{
+			for (int z = -view_radius; z <= view_radius; ++z)
+			{
+				ivec3 column = center + ivec3{ x, 0, z };
+				if (distance2(column) > view_radius * view_radius)
+					continue;
+
+				for (int y = stream_min_y; y < stream_max_y; ++y)
+				{
+					if (!chunks.contains({ column.x, y, column.z }))
+					{
+						load_queue.push_back(column);
+						break;
+					}
+				}
+			}
+		}
+
+		std::sort(load_queue.begin(), load_queue.end(), [&](ivec3 a, ivec3 b) {
+			return distance2(a) > distance2(b);
+		});
+	}
+
+	// Whole columns at a time, so they share one heightmap.
+	std::vector<ivec3> positions;
+
+	while (!load_queue.empty() && positions.size() < stream_loads_per_frame)
+	{
+		ivec3 column = load_queue.back();
+		load_queue.pop_back();
+
+		for (int y = stream_min_y; y < stream_max_y; ++y)
+			if (ivec3 pos{ column.x, y, column.z }; !chunks.contains(pos))
+				positions.push_back(pos);
+	}
+
+	auto loaded = load_chunks(gen, positions);
+
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		chunks.emplace(positions[i], std::move(loaded[i]));
+
+		// Chunks meshed before this one arrived have their border open towards it.
+		mark_neighbours_dirty(positions[i]);
+	}
+
+	light.light_chunks(*this, positions);
+
+	stream_stats.loads += positions.size();
+	stream_stats.pending = load_queue.size();
 }
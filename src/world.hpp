@@ -1,18 +1,247 @@
 #pragma once
 
 #include "chunk.hpp"
+#include "chunk_grid.hpp"
+#include "chunk_mesher.hpp"
+#include "light.hpp"
+#include "parallel.hpp"
+#include "region.hpp"
 
+#include <chrono>
 #include <random>
+#include <span>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
 
 class NoiseGenerator;
 
+struct WorldMemoryStats
+{
+	size_t chunks = 0;
+	size_t palette_entries = 0;
+	size_t block_bytes = 0;       // palette storage only
+	size_t dense_block_bytes = 0; // same blocks stored as one ItemID each
+	size_t chunk_bytes = 0;       // whole chunks, including face masks
+	size_t overflow_chunks = 0;   // outside the ChunkGrid window
+	size_t cold_chunks = 0;
+	size_t cold_block_bytes = 0;  // ChunkCodec encoded blocks of cold chunks, part of block_bytes
+	size_t empty_chunks = 0;         // without solid blocks, never meshed or drawn
+	size_t uniform_solid_chunks = 0; // one solid block type, meshed on the border only
+	size_t light_bytes = 0;          // light levels of chunks not lit evenly, part of chunk_bytes
+};
+
+struct WorldStreamStats
+{
+	size_t loads = 0;   // total since start
+	size_t unloads = 0; // total since start
+	size_t pending = 0; // queued chunk column loads
+	size_t region_loads = 0; // loads read from region files instead of generated, total since start
+};
+
+struct WorldRenderStats
+{
+	size_t visible_chunks = 0;
+	size_t culled_chunks = 0; // outside the frustum or without solid blocks
+	size_t occluded_chunks = 0; // not reachable from the camera through open space
+	size_t triangles = 0;      // in meshes of visible chunks
+	size_t full_triangles = 0; // same chunks meshed without level of detail
+};
+
+struct WorldMeshStats
+{
+	size_t queued = 0;          // dirty chunks waiting for a mesh job
+	size_t in_flight = 0;       // mesh jobs submitted and not collected yet
+	size_t pending_uploads = 0; // finished meshes left for the next frames
+	size_t submitted = 0;       // this frame
+	size_t skipped = 0;         // this frame, dirty chunks without faces cleared without a job
+	size_t uploaded = 0;        // this frame, without edited chunks
+	float used_ms = 0.0f;       // render thread time spent on meshes this frame
+};
+
+// Dirty chunk waiting in World::remesh_queue, lower priority first.
+struct RemeshRequest
+{
+	uint64_t priority;
+	ivec3 pos;
+	Chunk *chunk;
+};
+
+// Terrain surface of one chunk column, shared by every chunk stacked in it.
+struct ColumnHeightmap
+{
+	int heights[Chunk::EDGE_SIZE][Chunk::EDGE_SIZE]; // [x][z], world y of the lowest air block
+	int min_height = 0;
+	int max_height = 0;
+};
+
+struct Ray
+{
+	vec3 origin;
+	vec3 dir; // any length but zero
+	float max_dist; // in blocks, finite
+};
+
+struct RaycastHit
+{
+	bool hit = false;
+	ivec3 block{};         // world position of the solid block hit
+	Direction face{};      // face of block the ray entered through
+	float distance = 0.0f; // in blocks from the origin
+};
+
+struct BlockEdit
+{
+	ivec3 pos; // world block position
+	ItemID id;
+};
+
 struct World
 {
-	std::unordered_map<ivec3, std::unique_ptr<Chunk>> chunks;
+	ChunkGrid chunks;
+
+	// Dirty chunks are meshed in the background, results older than
+	// Chunk::mesh_version are dropped. Versions are unique across regenerations.
+	// Chunks keep drawing their previous mesh until the new one is uploaded.
+	std::unique_ptr<ChunkMesher> mesher;
+	std::vector<std::unique_ptr<ChunkMeshJob>> completed_meshes; // collected, not uploaded yet
+	uint64_t mesh_version = 0;
+
+	// Dirty chunks are submitted nearest first, chunks in the frustum before
+	// the rest. Each frame, submitting and uploading stop once they took
+	// mesh_budget_ms, after at least one of each. 0 disables the budget.
+	// At most max_mesh_jobs_in_flight jobs are submitted at a time, so chunks
+	// that come into view later do not wait behind the whole backlog.
+	float mesh_budget_ms = 2.0f;
+	size_t max_mesh_jobs_in_flight = 64; // 0 disables the limit
+	size_t mesh_jobs_in_flight = 0;
+	std::vector<RemeshRequest> remesh_queue; // heap, rebuilt every frame
+	WorldMeshStats mesh_stats;
+
+	// Chunks touched by set_block since they were last meshed. They are
+	// meshed on the render thread at the start of on_render, once however
+	// many edits they got, as soon as the light of the edits is done.
+	std::unordered_set<ivec3> edited_chunks;
+	Frame edit_frame;
+
+	// Sky and block light. Light changes of edits get light_steps_per_frame
+	// queue entries each frame, 0 disables the limit. Edited chunks and
+	// chunks whose light changed are remeshed once the queues run empty,
+	// see mesh_edited_chunks.
+	WorldLight light;
+	size_t light_steps_per_frame = 65536;
+
+	// Threads used by chunk loading and batched raycasts, 0 uses all
+	// hardware threads. They are started once, see thread_pool.
+	size_t thread_count = 0;
+	mutable std::unique_ptr<ThreadPool> pool;
+
+	// Chunks are read from region files in region_dir when stored there and
+	// generated otherwise. Empty disables region files.
+	std::filesystem::path region_dir;
+	// Region files only load into worlds with the seed and generator version
+	// they were saved with, their chunks would not fit the generated terrain
+	// around them otherwise. Bump GENERATOR_VERSION when the terrain changes.
+	static const uint32_t GENERATOR_VERSION = 1;
+	uint32_t seed = 0; // of the NoiseGenerator passed to init and stream
+	std::unordered_map<ivec3, std::unique_ptr<RegionFile>> regions; // null when there is no file
+	// Chunks unloaded by stream with edits that save_regions has not written
+	// yet, ChunkCodec encoded. Loading takes them before region files.
+	std::unordered_map<ivec3, std::vector<uint8_t>> unloaded_edits;
+
+	// Terrain surface heights span [1, terrain_height] blocks, everything
+	// below the surface is solid.
+	int terrain_height = 64;
+
+	// Streaming, see stream. load_queue holds chunk columns (y = 0) sorted
+	// with the nearest one last, each loads chunk layers [stream_min_y, stream_max_y).
+	std::vector<ivec3> load_queue;
+	ivec3 stream_center{};
+	int stream_radius = -1;
+	int stream_min_y = 0;
+	int stream_max_y = 4;
+	size_t stream_loads_per_frame = 32; // chunks, rounded up to whole columns
+	WorldStreamStats stream_stats;
+
+	WorldRenderStats render_stats;
+	bool cave_culling = true;
+	uint64_t frame_index = 0;
+
+	// Chunks not drawn for cold_frames frames are frozen (see Chunk::freeze),
+	// at most freezes_per_frame per frame. 0 disables freezing.
+	uint64_t cold_frames = 600;
+	size_t freezes_per_frame = 32;
+
+	// Chunks are meshed at level k (see Chunk::reduce_to_lod) from k * lod_distance
+	// chunks away from the camera. 0 disables level of detail.
+	int lod_distance = 0;
+
+	WorldMemoryStats memory_stats() const;
+	// Pool of thread_count threads, restarted when thread_count changed.
+	ThreadPool &thread_pool() const;
+
+	static ivec3 chunk_of(ivec3 world_pos);
+	// False outside loaded chunks.
+	bool is_solid_block(ivec3 world_pos) const;
+	// Air outside loaded chunks, thaws cold chunks.
+	ItemID get_block(ivec3 world_pos);
+	// Updates the solidity of the block and marks its chunk for remeshing, with
+	// the neighbour chunks it borders when its solidity changed. Returns false
+	// when the chunk is not loaded.
+	bool set_block(ivec3 world_pos, ItemID id);
+	void set_blocks(std::span<BlockEdit const> edits);
+
+	// First solid block along the ray, from solidity only so cold chunks are
+	// not thawed. Walks chunk cells through empty and unloaded chunks and
+	// blocks inside the others. A ray starting in a solid block hits it at 0.
+	RaycastHit raycast(vec3 origin, vec3 dir, float max_dist) const;
+	// Casts rays in parallel on thread_count threads, hits[i] for rays[i].
+	void raycast(std::span<Ray const> rays, std::span<RaycastHit> hits) const;
+	// Spreads queued light changes. Once the queues are empty, marks relit
+	// chunks dirty, then refreshes bounds and connectivity of edited_chunks
+	// and meshes them on this thread. Until then edited_chunks are kept.
+	std::vector<std::unique_ptr<ChunkMeshJob>> mesh_edited_chunks(MaterialManager const &materials);
+
+	// Marks chunks reachable from the camera through open space by setting
+	// Chunk::reached_frame to frame_index.
+	void find_reachable_chunks(vec3 camera_pos, Frustum const *frustum);
+	int select_lod(ivec3 pos, vec3 camera_pos) const;
+	std::unique_ptr<ChunkMeshJob> create_mesh_job(ivec3 pos, Chunk &chunk, MaterialManager const &materials);
+	// Queues dirty chunks by priority and submits mesh jobs until deadline.
+	// Returns the number of jobs submitted.
+	size_t schedule_meshes(vec3 camera_pos, Frustum const *frustum, MaterialManager const &materials, std::chrono::steady_clock::time_point deadline);
+	// Moves finished mesh jobs to completed_meshes.
+	void collect_meshes();
+	// False for chunks that cannot have visible faces, empty chunks and
+	// uniform solid chunks covered on every side.
+	bool needs_mesh(ivec3 pos, Chunk const &chunk) const;
+	// Loads the mesh into its chunk, or clears it when the mesh is empty.
+	// False when the chunk is gone or the mesh is outdated.
+	bool upload_mesh(RenderParams const &params, ChunkMeshJob &job);
+	// Neighbours mesh against the border of pos, remesh them when it changes.
+	void mark_neighbours_dirty(ivec3 pos);
 
 	void on_render(RenderParams const &params);
 	void init_random_chunks(std::mt19937 &rng, ivec3 from, ivec3 to, int count);
 	void init(NoiseGenerator const &gen, ivec3 from, ivec3 to);
+	// Opens the region files containing positions, so read_chunk can read
+	// them from any thread.
+	void open_regions(std::vector<ivec3> const &positions);
+	// Unsaved edits of an unloaded chunk or region file content, null when
+	// the chunk is not stored. Solidity is not refreshed.
+	std::unique_ptr<Chunk> read_chunk(ivec3 pos) const;
+	// Chunks from region files when stored, generated otherwise, with solidity
+	// refreshed. Runs in parallel and computes each column heightmap once.
+	std::vector<std::unique_ptr<Chunk>> load_chunks(NoiseGenerator const &gen, std::vector<ivec3> const &positions);
+	// Writes all loaded chunks and unloaded_edits to region_dir, keeping
+	// chunks stored but not loaded. Chunks count as unmodified afterwards.
+	bool save_regions();
+
+	// Keeps chunk columns within view_radius of camera_pos loaded, nearest first,
+	// and unloads columns farther than unload_radius (in chunks, unload_radius > view_radius).
+	void stream(NoiseGenerator const &gen, vec3 camera_pos, int view_radius, int unload_radius);
+
+	ColumnHeightmap generate_heightmap(NoiseGenerator const &gen, int column_x, int column_z) const;
+	// Chunks entirely above or below the surface are filled without visiting blocks.
+	static std::unique_ptr<Chunk> generate_chunk(ColumnHeightmap const &heightmap, ivec3 pos);
 };